@@ -0,0 +1,64 @@
+#pragma once
+
+// Stream standing in for the Minitel serial port: counts and optionally
+// records every byte written, and serves bytes queued with feed().
+
+#include <Arduino.h>
+
+#include <deque>
+#include <vector>
+
+class MockStream : public Stream
+{
+public:
+    // Bytes written since construction / reset(), and their FNV-1a hash
+    // (to tell whether a change altered the output at all)
+    size_t bytes = 0;
+    uint32_t hash = 2166136261u;
+
+    // Kept only while `record` is true
+    std::vector<uint8_t> output;
+    bool record = false;
+
+    // What availableForWrite() reports (a UART buffer of that size that
+    // drains instantly)
+    int writeRoom = 64;
+
+    void reset()
+    {
+        bytes = 0;
+        hash = 2166136261u;
+        output.clear();
+    }
+
+    // Input as if typed on the terminal
+    void feed(const uint8_t *data, size_t len) { input_.insert(input_.end(), data, data + len); }
+    void feed(uint8_t b) { input_.push_back(b); }
+
+    size_t write(uint8_t b) override
+    {
+        ++bytes;
+        hash = (hash ^ b) * 16777619u;
+        if (record)
+            output.push_back(b);
+        return 1;
+    }
+
+    int availableForWrite() override { return writeRoom; }
+
+    int available() override { return (int)input_.size(); }
+
+    int read() override
+    {
+        if (input_.empty())
+            return -1;
+        int b = input_.front();
+        input_.pop_front();
+        return b;
+    }
+
+    int peek() override { return input_.empty() ? -1 : input_.front(); }
+
+private:
+    std::deque<uint8_t> input_;
+};
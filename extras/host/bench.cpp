@@ -0,0 +1,330 @@
+// Canned scenes through the real Minitel / MinitelGfx code, reporting
+// what goes on the wire. Run `make run` in this directory.
+//
+// For each scene: bytes per frame (mean / max), time on the wire per
+// frame at 1200 / 4800 / 9600 baud (7E1: 10 bits per byte), host CPU
+// time per frame (draw + flush) and a hash of the whole output, so an
+// encoder change can be checked for "smaller" as well as "unchanged".
+
+#include <Minitel.h>
+#include <MinitelGfx.h>
+
+#include "MockStream.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+
+// Same numbers on every host, unlike rand()
+uint32_t rng = 1;
+uint16_t nextRandom(uint16_t n)
+{
+    rng = rng * 1103515245u + 12345u;
+    return (uint16_t)((rng >> 16) % n);
+}
+
+// 16x16, two frames
+const uint8_t walker[] PROGMEM = {
+    MGFX_ROW16(0,0,0,0,0,1,1,1,1,1,1,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,1,1,1,1,1,1,1,1,1,1,0,0,0),
+    MGFX_ROW16(0,0,1,1,1,1,1,1,1,1,1,1,1,1,0,0),
+    MGFX_ROW16(0,1,1,1,0,0,1,1,1,1,0,0,1,1,1,0),
+    MGFX_ROW16(0,1,1,1,0,0,1,1,1,1,0,0,1,1,1,0),
+    MGFX_ROW16(1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1),
+    MGFX_ROW16(1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1),
+    MGFX_ROW16(1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1),
+    MGFX_ROW16(1,1,1,0,1,1,1,1,1,1,1,1,0,1,1,1),
+    MGFX_ROW16(1,1,1,1,0,0,1,1,1,1,0,0,1,1,1,1),
+    MGFX_ROW16(0,1,1,1,1,1,0,0,0,0,1,1,1,1,1,0),
+    MGFX_ROW16(0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0),
+    MGFX_ROW16(0,0,1,1,1,1,1,1,1,1,1,1,1,1,0,0),
+    MGFX_ROW16(0,0,0,1,1,0,0,0,0,0,0,1,1,0,0,0),
+    MGFX_ROW16(0,0,1,1,0,0,0,0,0,0,0,0,1,1,0,0),
+    MGFX_ROW16(0,1,1,0,0,0,0,0,0,0,0,0,0,1,1,0),
+
+    MGFX_ROW16(0,0,0,0,0,1,1,1,1,1,1,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,1,1,1,1,1,1,1,1,1,1,0,0,0),
+    MGFX_ROW16(0,0,1,1,1,1,1,1,1,1,1,1,1,1,0,0),
+    MGFX_ROW16(0,1,1,1,0,0,1,1,1,1,0,0,1,1,1,0),
+    MGFX_ROW16(0,1,1,1,0,0,1,1,1,1,0,0,1,1,1,0),
+    MGFX_ROW16(1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1),
+    MGFX_ROW16(1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1),
+    MGFX_ROW16(1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1),
+    MGFX_ROW16(1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1),
+    MGFX_ROW16(1,1,1,1,0,0,0,0,0,0,0,0,1,1,1,1),
+    MGFX_ROW16(0,1,1,1,1,0,0,0,0,0,0,1,1,1,1,0),
+    MGFX_ROW16(0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0),
+    MGFX_ROW16(0,0,1,1,1,1,1,1,1,1,1,1,1,1,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,0,0,0,0,1,1,0,0,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,0,0,0,0,1,1,0,0,0,0),
+    MGFX_ROW16(0,0,0,1,1,0,0,0,0,0,0,1,1,0,0,0),
+};
+
+// 12x12 arrow
+const uint8_t arrow[] PROGMEM = {
+    MGFX_ROW16(0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,1,1,0,0,0,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,1,1,1,1,1,1,0,0,0,0,0,0,0),
+    MGFX_ROW16(0,0,1,1,1,1,1,1,1,1,0,0,0,0,0,0),
+    MGFX_ROW16(0,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0),
+    MGFX_ROW16(1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,1,1,0,0,0,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,1,1,0,0,0,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,1,1,0,0,0,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,1,1,0,0,0,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,1,1,0,0,0,0,0,0,0,0),
+    MGFX_ROW16(0,0,0,0,1,1,1,1,0,0,0,0,0,0,0,0),
+};
+
+// For Minitel::dumpStats()
+class StdoutPrint : public Print
+{
+public:
+    size_t write(uint8_t b) override
+    {
+        return fputc(b, stdout) == EOF ? 0 : 1;
+    }
+};
+
+bool verbose = false;
+
+struct Scene
+{
+    const char *name;
+    uint16_t frames;
+    void (*setup)(MinitelGfx &gfx);
+    void (*frame)(MinitelGfx &gfx, uint16_t i);
+    const char *skipped; // why this build can't play it, else null
+};
+
+// ---------------------- Scenes -------------------------
+
+MinitelGfx::Sprite sprite;
+
+void noSetup(MinitelGfx &) {}
+
+// Whole screen lit, then blanked, alternately
+void fullClearFrame(MinitelGfx &gfx, uint16_t i)
+{
+    if (i & 1)
+    {
+        gfx.clearCells(0, 0, MinitelGfx::CELL_COLS - 1, MinitelGfx::CELL_ROWS - 1);
+    }
+    else
+    {
+        gfx.setDrawColor(static_cast<Minitel::Color>(1 + (i / 2) % 7));
+        gfx.drawRect(0, 0, MinitelGfx::PIXEL_COLS, MinitelGfx::PIXEL_ROWS, true);
+    }
+    gfx.flush();
+}
+
+void walkSetup(MinitelGfx &gfx)
+{
+    gfx.spriteInit(sprite, walker, 16, 16, 2, MinitelGfx::SpriteFormat::PackedProgmem);
+    gfx.setDrawColor(Minitel::Color::Yellow);
+    gfx.drawRect(0, 60, MinitelGfx::PIXEL_COLS, 12, true); // ground
+}
+
+void walkFrame(MinitelGfx &gfx, uint16_t i)
+{
+    // Back and forth along the ground, one pixel per frame
+    uint16_t span = MinitelGfx::PIXEL_COLS - 16;
+    uint16_t p = i % (2 * span);
+    int16_t x = (p < span) ? p : 2 * span - p;
+
+    gfx.setDrawColor(Minitel::Color::Cyan);
+    gfx.spriteSetPosition(sprite, x, 44);
+    if (i % 4 == 0)
+        gfx.spriteNextFrame(sprite);
+    gfx.spriteDraw(sprite);
+    gfx.flush();
+}
+
+void rotateSetup(MinitelGfx &gfx)
+{
+    gfx.spriteInit(sprite, arrow, 12, 12, 1, MinitelGfx::SpriteFormat::PackedProgmem);
+    gfx.spriteSetPosition(sprite, 34, 30);
+}
+
+void rotateFrame(MinitelGfx &gfx, uint16_t)
+{
+    gfx.setDrawColor(Minitel::Color::Green);
+    gfx.spriteRotateBy(sprite, 10);
+    gfx.spriteDraw(sprite);
+    gfx.flush();
+}
+
+#if MGFX_TEXT_PLANE
+void hudSetup(MinitelGfx &gfx)
+{
+    gfx.fillCells(0, 0, MinitelGfx::CELL_COLS - 1, 1, Minitel::Color::Blue);
+    gfx.setDrawColor(Minitel::Color::Yellow);
+    gfx.setTextAttributes(Minitel::CharSize::DoubleHeight);
+    gfx.drawText(1, 1, "SCORE");
+    gfx.setTextAttributes(Minitel::CharSize::Normal);
+    gfx.setDrawColor(Minitel::Color::White);
+    gfx.drawText(26, 1, "TIME");
+}
+
+void hudFrame(MinitelGfx &gfx, uint16_t i)
+{
+    char buf[8];
+    uint32_t score = (uint32_t)i * 130;
+    for (int8_t d = 5; d >= 0; --d)
+    {
+        buf[d] = '0' + score % 10;
+        score /= 10;
+    }
+    buf[6] = '\0';
+    gfx.setDrawColor(Minitel::Color::White);
+    gfx.drawText(8, 1, buf);
+
+    uint16_t t = 999 - i;
+    buf[0] = '0' + t / 100;
+    buf[1] = '0' + t / 10 % 10;
+    buf[2] = '0' + t % 10;
+    buf[3] = '\0';
+    gfx.drawText(31, 1, buf);
+    gfx.flush();
+}
+#endif
+
+const uint8_t BARS = 10;
+uint8_t barHeight[BARS];
+
+void chartSetup(MinitelGfx &gfx)
+{
+    gfx.setDrawColor(Minitel::Color::White);
+    gfx.drawLine(0, 71, 79, 71);
+    for (uint8_t b = 0; b < BARS; ++b)
+    {
+        barHeight[b] = 10 + nextRandom(50);
+        gfx.setDrawColor(static_cast<Minitel::Color>(1 + b % 7));
+        gfx.drawRect(2 + b * 8, 70 - barHeight[b], 6, barHeight[b], true);
+    }
+}
+
+void chartFrame(MinitelGfx &gfx, uint16_t)
+{
+    // Each bar drifts a few pixels up or down
+    for (uint8_t b = 0; b < BARS; ++b)
+    {
+        int16_t h = barHeight[b] + (int16_t)nextRandom(9) - 4;
+        if (h < 2) h = 2;
+        if (h > 68) h = 68;
+
+        int16_t x = 2 + b * 8;
+        if (h < barHeight[b])
+            gfx.drawRect(x, 70 - barHeight[b], 6, barHeight[b] - h, true, false);
+        gfx.setDrawColor(static_cast<Minitel::Color>(1 + b % 7));
+        gfx.drawRect(x, 70 - h, 6, h, true);
+        barHeight[b] = h;
+    }
+    gfx.flush();
+}
+
+const Scene SCENES[] = {
+    {"full-clear", 40, noSetup, fullClearFrame, nullptr},
+    {"sprite-walk", 256, walkSetup, walkFrame, nullptr},
+    {"rotating-sprite", 144, rotateSetup, rotateFrame, nullptr},
+#if MGFX_TEXT_PLANE
+    {"text-hud", 200, hudSetup, hudFrame, nullptr},
+#else
+    {"text-hud", 200, noSetup, nullptr, "needs MGFX_TEXT_PLANE"},
+#endif
+    {"bar-chart", 200, chartSetup, chartFrame, nullptr},
+};
+
+// ---------------------- Harness -------------------------
+
+double wireMs(double bytes, uint32_t baud)
+{
+    return bytes * 10.0 * 1000.0 / baud;
+}
+
+void run(const Scene &scene)
+{
+    if (scene.skipped)
+    {
+        printf("%-16s skipped: %s\n", scene.name, scene.skipped);
+        return;
+    }
+
+    MockStream port;
+    Minitel minitel;
+    minitel.begin(&port);
+    MinitelGfx gfx(minitel);
+    rng = 1;
+
+    // Setup and first flush are not part of the frames
+    gfx.clear(true);
+    scene.setup(gfx);
+    gfx.flush();
+    minitel.flushTx();
+    port.reset();
+    minitel.resetStats();
+
+    size_t maxBytes = 0;
+    double cpuUs = 0;
+    for (uint16_t i = 0; i < scene.frames; ++i)
+    {
+        size_t before = port.bytes;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        scene.frame(gfx, i);
+        minitel.flushTx();
+        cpuUs += std::chrono::duration<double, std::micro>(
+                     std::chrono::steady_clock::now() - t0).count();
+
+        size_t n = port.bytes - before;
+        if (n > maxBytes)
+            maxBytes = n;
+    }
+
+    double mean = (double)port.bytes / scene.frames;
+    printf("%-16s %6u %8zu %7.1f %6zu %8.1f %7.1f %7.1f %8.1f  %08x\n",
+           scene.name, scene.frames, port.bytes, mean, maxBytes,
+           wireMs(mean, 1200), wireMs(mean, 4800), wireMs(mean, 9600),
+           cpuUs / scene.frames, port.hash);
+    if (gfx.lostCells())
+        printf("%-16s %u cell writes lost by the compact shadow\n", "",
+               gfx.lostCells());
+
+    if (verbose)
+    {
+        StdoutPrint out;
+        minitel.dumpStats(&out);
+        printf("\n");
+    }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    printf("%-16s %6s %8s %7s %6s %8s %7s %7s %8s  %s\n",
+           "scene", "frames", "bytes", "B/frm", "max", "ms@1200", "@4800",
+           "@9600", "cpu us", "hash");
+
+    int named = 0;
+    for (int a = 1; a < argc; ++a)
+    {
+        if (strcmp(argv[a], "-v") == 0)
+            verbose = true;
+        else
+            ++named;
+    }
+
+    for (const Scene &scene : SCENES)
+    {
+        bool selected = (named == 0);
+        for (int a = 1; a < argc; ++a)
+            if (strcmp(argv[a], scene.name) == 0)
+                selected = true;
+        if (selected)
+            run(scene);
+    }
+    return 0;
+}
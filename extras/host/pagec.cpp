@@ -0,0 +1,253 @@
+// Page compiler: draws a static page with the real MinitelGfx code and
+// writes it out as a C header of PROGMEM arrays, for
+// MinitelGfx::sendCompiled() or Minitel::writeProgmem().
+//
+//   ./pagec menu.page menu > menu_page.h
+//   ./pagec -s menu.scene menu > menu_page.h   (a saveScene() dump)
+//
+// gives
+//
+//   menu_stream[]  FF, then what flush() sends for the page: the same
+//                  encoder as at run time (REP, attributes, cursor
+//                  moves), so the same bytes without the CPU and RAM
+//   menu_scene[]   the page as packScene() data, to diff from later
+//
+// Page description, one command per line, `#` starts a comment (but
+// not in text).
+// Pixels are 0..79 x 0..71, cells 0..39 x 0..23:
+//
+//   color <fg> [<bg>]          black red green yellow blue magenta
+//                              cyan white
+//   size normal|tall|wide|double
+//   text <col> <row> <text>    the rest of the line
+//   pixel <x> <y>
+//   line <x0> <y0> <x1> <y1>
+//   rect <x> <y> <w> <h>
+//   box <x> <y> <w> <h>        filled rect
+//   circle <cx> <cy> <r> [fill]
+//   panel <c0> <r0> <c1> <r1>  cells on the background colour
+//   clear <c0> <r0> <c1> <r1>
+
+#include <Minitel.h>
+#include <MinitelGfx.h>
+
+#include "MockStream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+
+MockStream wire;
+Minitel minitel;
+MinitelGfx gfx(minitel);
+
+const char *const COLORS[] = {"black", "red", "green", "yellow",
+                              "blue", "magenta", "cyan", "white"};
+
+bool parseColor(const char *s, Minitel::Color &c)
+{
+    for (uint8_t i = 0; i < 8; ++i)
+        if (strcmp(s, COLORS[i]) == 0)
+        {
+            c = (Minitel::Color)i;
+            return true;
+        }
+    return false;
+}
+
+#if MGFX_TEXT_PLANE
+bool parseSize(const char *s, Minitel::CharSize &size)
+{
+    static const char *const SIZES[] = {"normal", "tall", "wide", "double"};
+    for (uint8_t i = 0; i < 4; ++i)
+        if (strcmp(s, SIZES[i]) == 0)
+        {
+            size = (Minitel::CharSize)i;
+            return true;
+        }
+    return false;
+}
+#endif
+
+// Up to `max` integers from s; returns how many, and where they stop
+int parseInts(const char *&s, int *v, int max)
+{
+    int n = 0;
+    while (n < max)
+    {
+        char *end;
+        long x = strtol(s, &end, 10);
+        if (end == s)
+            break;
+        v[n++] = (int)x;
+        s = end;
+    }
+    while (*s == ' ' || *s == '\t')
+        ++s;
+    return n;
+}
+
+// One command; false (with a message) if it is not understood
+bool runLine(const char *file, int lineNo, char *line)
+{
+    line[strcspn(line, "\r\n")] = 0;
+
+    char cmd[16];
+    int used = 0;
+    if (sscanf(line, " %15s %n", cmd, &used) != 1 || cmd[0] == '#')
+        return true; // blank
+    const char *args = line + used;
+
+    // Text runs to the end of the line, after its two numbers
+    bool text = strcmp(cmd, "text") == 0;
+    if (!text)
+        line[strcspn(line, "#")] = 0;
+
+    int v[4];
+    int n = parseInts(args, v, text ? 2 : 4);
+    bool ok = true;
+
+    if (strcmp(cmd, "color") == 0)
+    {
+        char fg[16], bg[16];
+        int k = sscanf(args, "%15s %15s", fg, bg);
+        Minitel::Color c;
+        ok = k >= 1 && parseColor(fg, c);
+        if (ok)
+            gfx.setDrawColor(c);
+        if (ok && k == 2 && (ok = parseColor(bg, c)))
+            gfx.setDrawBgColor(c);
+    }
+#if MGFX_TEXT_PLANE
+    else if (strcmp(cmd, "size") == 0)
+    {
+        Minitel::CharSize size;
+        ok = parseSize(args, size);
+        if (ok)
+            gfx.setTextAttributes(size);
+    }
+    else if (text && n == 2)
+        gfx.drawText((uint8_t)v[0], (uint8_t)v[1], args);
+#else
+    else if (text || strcmp(cmd, "size") == 0)
+    {
+        fprintf(stderr, "%s:%d: \"%s\" needs MGFX_TEXT_PLANE\n", file, lineNo, line);
+        return false;
+    }
+#endif
+    else if (strcmp(cmd, "pixel") == 0 && n == 2)
+        gfx.drawPixel(v[0], v[1]);
+    else if (strcmp(cmd, "line") == 0 && n == 4)
+        gfx.drawLine(v[0], v[1], v[2], v[3]);
+    else if (strcmp(cmd, "rect") == 0 && n == 4)
+        gfx.drawRect(v[0], v[1], v[2], v[3], false);
+    else if (strcmp(cmd, "box") == 0 && n == 4)
+        gfx.drawRect(v[0], v[1], v[2], v[3], true);
+    else if (strcmp(cmd, "circle") == 0 && n == 3)
+        gfx.drawCircle(v[0], v[1], v[2], strcmp(args, "fill") == 0);
+    else if (strcmp(cmd, "panel") == 0 && n == 4)
+        gfx.fillCells(v[0], v[1], v[2], v[3], gfx.drawBgColor());
+    else if (strcmp(cmd, "clear") == 0 && n == 4)
+        gfx.clearCells(v[0], v[1], v[2], v[3]);
+    else
+        ok = false;
+
+    if (!ok)
+        fprintf(stderr, "%s:%d: cannot read \"%s\"\n", file, lineNo, line);
+    return ok;
+}
+
+bool drawPage(const char *file)
+{
+    FILE *f = fopen(file, "r");
+    if (!f)
+    {
+        perror(file);
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof line, f))
+        ok = runLine(file, ++lineNo, line);
+    fclose(f);
+    return ok;
+}
+
+bool loadScene(const char *file)
+{
+    static uint8_t scene[MinitelGfx::SCENE_BYTES];
+    FILE *f = fopen(file, "rb");
+    if (!f)
+    {
+        perror(file);
+        return false;
+    }
+    size_t n = fread(scene, 1, sizeof scene, f);
+    fclose(f);
+    if (n != sizeof scene)
+    {
+        fprintf(stderr, "%s: %zu bytes, a scene is %u\n", file, n,
+                (unsigned)sizeof scene);
+        return false;
+    }
+    gfx.loadScene(scene);
+    return true;
+}
+
+void printArray(const char *name, const char *suffix,
+                const uint8_t *data, size_t len)
+{
+    printf("static const uint8_t %s_%s[] PROGMEM = {", name, suffix);
+    for (size_t i = 0; i < len; ++i)
+        printf("%s0x%02X,", (i % 12) ? " " : "\n    ", data[i]);
+    printf("\n};\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    bool sceneFile = argc == 4 && strcmp(argv[1], "-s") == 0;
+    if (argc != 3 && !sceneFile)
+    {
+        fprintf(stderr, "usage: %s [-s] <page | scene> <name>\n", argv[0]);
+        return 2;
+    }
+    const char *input = argv[argc - 2];
+    const char *name = argv[argc - 1];
+
+    minitel.begin(&wire);
+    minitel.flushTx();
+    wire.reset();
+    wire.record = true;
+
+    // From FF, so the stream does not depend on the screen before it
+    gfx.clear(true);
+    if (!(sceneFile ? loadScene(input) : drawPage(input)))
+        return 1;
+    gfx.flush();
+    minitel.flushTx();
+    if (gfx.lostCells())
+    {
+        fprintf(stderr, "%s: %u cell writes lost by the compact shadow, raise "
+                        "MGFX_COMPACT_SIDE_CELLS\n", input, gfx.lostCells());
+        return 1;
+    }
+
+    static uint8_t packed[MinitelGfx::SCENE_BYTES + 64];
+    uint16_t packedLen = gfx.packScene(packed, sizeof packed);
+
+    printf("// Generated by extras/host/pagec from %s:\n"
+           "// %zu bytes on the wire, %u bytes of scene.\n"
+           "#pragma once\n\n"
+           "#include <Arduino.h>\n\n",
+           input, wire.output.size(), packedLen);
+    printArray(name, "stream", wire.output.data(), wire.output.size());
+    printf("\n");
+    printArray(name, "scene", packed, packedLen);
+    return 0;
+}
@@ -0,0 +1,771 @@
+// Reads a MinitelRecorder dump (see src/MinitelRecorder.h) back into a
+// timeline, then sends the same frames through the current encoder with
+// the benchmark's setup, to compare a real session against a change.
+//
+//   ./replay session.mrec          summary
+//   ./replay -v session.mrec       and every frame, request, mark
+//   make clean replay CPPFLAGS=-DMGFX_COMPACT_SHADOW=1
+//
+// Per frame (one MinitelGfx::flush()): time spent in flush(), bytes it
+// queued, when the port took its first and last byte (from the start
+// of flush(), so the last is the display latency, plus one character
+// time in the UART), time blocked in the port's write() meanwhile, and
+// the bytes the encoder of this build sends for the same change.
+//
+// The screen after each frame is rebuilt from the TX bytes by a model
+// of the terminal (positioning, SO / SI, REP, colours, sizes, roll
+// mode), then redrawn in a MinitelGfx cell by cell. Characters in
+// DRCS are not modelled: they are counted and replayed as blanks.
+
+#include <Minitel.h>
+#include <MinitelGfx.h>
+#include <MinitelRecorder.h>
+
+#include "MockStream.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+
+bool verbose = false;
+
+// ---------------------- Terminal model -------------------------
+
+struct Cell
+{
+    uint8_t code = 0x20;
+    uint8_t fg = 7, bg = 0;
+    uint8_t size = 0;  // Minitel::CharSize
+    uint8_t part = 0;  // 0: the character's own cell, else covered by it
+    bool g1 = false, drcs = false, negative = false, flash = false;
+
+    bool operator==(const Cell &o) const
+    {
+        return code == o.code && fg == o.fg && bg == o.bg && size == o.size &&
+               part == o.part && g1 == o.g1 && drcs == o.drcs &&
+               negative == o.negative && flash == o.flash;
+    }
+    bool operator!=(const Cell &o) const { return !(*this == o); }
+};
+
+class Screen
+{
+public:
+    Cell cells[24][40]; // rows 1..24; row 00 is not kept
+
+    Screen() { clear(); }
+
+    void feed(uint8_t b)
+    {
+        b &= 0x7F;
+        switch (state_)
+        {
+        case ESC:
+            state_ = NORMAL;
+            escape(b);
+            return;
+        case SKIP:
+            args_[argc_++] = b;
+            if (--skip_ == 0)
+            {
+                state_ = NORMAL;
+                // PRO2 roll mode on / off: ESC 3/A 6/9 (6/A) 4/3
+                if (escCode_ == 0x3A && args_[1] == 0x43)
+                {
+                    if (args_[0] == 0x69)
+                        roll_ = true;
+                    else if (args_[0] == 0x6A)
+                        roll_ = false;
+                }
+            }
+            return;
+        case DESIGNATE:
+            if (b == 0x20)
+            {
+                escCode_ |= 0x80;
+                return;
+            }
+            state_ = NORMAL;
+            if ((escCode_ & 0x7F) == 0x28)
+                attr_.drcs = (escCode_ & 0x80) && b == 0x42;
+            return;
+        case CSI:
+            if (b >= 0x40)
+                state_ = NORMAL;
+            return;
+        case US_ROW:
+            if (b == 0x23)
+            {
+                state_ = DRCS_LOAD;
+                return;
+            }
+            usRow_ = b;
+            state_ = US_COL;
+            return;
+        case US_COL:
+            state_ = NORMAL;
+            position(usRow_, b);
+            return;
+        case DRCS_LOAD:
+            if (b != 0x1F)
+                return;
+            state_ = NORMAL;
+            break;
+        case REP:
+            state_ = NORMAL;
+            for (uint8_t n = b & 0x3F; n > 0; --n)
+                put(last_);
+            return;
+        case NORMAL:
+            break;
+        }
+
+        if (b >= 0x20)
+        {
+            put(b);
+            return;
+        }
+        control(b);
+    }
+
+private:
+    enum State : uint8_t
+    {
+        NORMAL,
+        ESC,
+        SKIP,
+        DESIGNATE,
+        CSI,
+        US_ROW,
+        US_COL,
+        DRCS_LOAD,
+        REP
+    };
+
+    State state_ = NORMAL;
+    uint8_t escCode_ = 0, usRow_ = 0, skip_ = 0, argc_ = 0, args_[3] = {0};
+    uint8_t row_ = 1, col_ = 1, last_ = 0x20;
+    uint8_t savedRow_ = 1, savedCol_ = 1;
+    bool roll_ = false;
+    Cell attr_; // what the next character is written with
+
+    void resetAttributes()
+    {
+        bool drcs = attr_.drcs;
+        attr_ = Cell();
+        attr_.drcs = drcs;
+    }
+
+    void clear()
+    {
+        for (auto &row : cells)
+            for (Cell &c : row)
+                c = Cell();
+        row_ = col_ = 1;
+        resetAttributes();
+    }
+
+    void escape(uint8_t b)
+    {
+        if (b >= 0x40 && b <= 0x47)
+            attr_.fg = b & 0x07;
+        else if (b >= 0x50 && b <= 0x57)
+            attr_.bg = b & 0x07;
+        else if (b == 0x48 || b == 0x49)
+            attr_.flash = (b == 0x48);
+        else if (b >= 0x4C && b <= 0x4F)
+            attr_.size = b - 0x4C;
+        else if (b == 0x5C || b == 0x5D)
+            attr_.negative = (b == 0x5D);
+        else if (b >= 0x39 && b <= 0x3B)
+        {
+            // PRO1 / PRO2 / PRO3
+            state_ = SKIP;
+            escCode_ = b;
+            skip_ = b - 0x38;
+            argc_ = 0;
+        }
+        else if (b == 0x5B)
+            state_ = CSI;
+        else if (b >= 0x28 && b <= 0x2B)
+        {
+            state_ = DESIGNATE;
+            escCode_ = b;
+        }
+    }
+
+    void position(uint8_t row, uint8_t col)
+    {
+        if (row == 0x40)
+        {
+            // Row 00: the LF leaving it comes back here
+            if (row_ != 0)
+            {
+                savedRow_ = row_;
+                savedCol_ = col_;
+            }
+            row_ = 0;
+        }
+        else if (row > 0x40 && row <= 0x58 && col > 0x40 && col <= 0x68)
+        {
+            row_ = row & 0x3F;
+            col_ = col & 0x3F;
+        }
+        resetAttributes();
+    }
+
+    void scroll(bool up)
+    {
+        if (up)
+            memmove(cells[0], cells[1], sizeof(cells) - sizeof(cells[0]));
+        else
+            memmove(cells[1], cells[0], sizeof(cells) - sizeof(cells[0]));
+        for (Cell &c : cells[up ? 23 : 0])
+            c = Cell();
+    }
+
+    void control(uint8_t b)
+    {
+        switch (b)
+        {
+        case 0x1B:
+            state_ = ESC;
+            break;
+        case 0x1F:
+            state_ = US_ROW;
+            break;
+        case 0x12:
+            state_ = REP;
+            break;
+        case 0x0E: // SO: G1 has no size or polarity
+            attr_.g1 = true;
+            attr_.size = 0;
+            attr_.negative = false;
+            break;
+        case 0x0F:
+            attr_.g1 = false;
+            break;
+        case 0x0C:
+            clear();
+            break;
+        case 0x1E:
+            row_ = col_ = 1;
+            resetAttributes();
+            break;
+        case 0x0D:
+            col_ = 1;
+            break;
+        case 0x08:
+            if (--col_ < 1)
+            {
+                col_ = 40;
+                if (row_ > 1)
+                    --row_;
+                else if (row_ == 1)
+                    row_ = 24;
+            }
+            break;
+        case 0x09:
+            if (++col_ > 40)
+            {
+                col_ = 1;
+                if (row_ > 0 && ++row_ > 24)
+                    row_ = 1;
+            }
+            break;
+        case 0x0A:
+            if (row_ == 0)
+            {
+                row_ = savedRow_;
+                col_ = savedCol_;
+            }
+            else if (row_ < 24)
+                ++row_;
+            else if (roll_)
+                scroll(true);
+            else
+                row_ = 1;
+            break;
+        case 0x0B:
+            if (row_ > 1)
+                --row_;
+            else if (roll_ && row_ == 1)
+                scroll(false);
+            else if (row_ == 1)
+                row_ = 24;
+            break;
+        case 0x18: // CAN: to the end of the row
+            for (uint8_t c = col_; row_ > 0 && c <= 40; ++c)
+                cells[row_ - 1][c - 1] = Cell();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void set(uint8_t row, uint8_t col, uint8_t code, uint8_t part)
+    {
+        if (row < 1 || row > 24 || col < 1 || col > 40)
+            return;
+        Cell &c = cells[row - 1][col - 1];
+        c = attr_;
+        c.code = code;
+        c.part = part;
+        c.drcs = !attr_.g1 && attr_.drcs;
+    }
+
+    void put(uint8_t code)
+    {
+        last_ = code;
+        bool wide = !attr_.g1 && (attr_.size & 2);
+        bool tall = !attr_.g1 && (attr_.size & 1);
+        set(row_, col_, code, 0);
+        if (wide)
+            set(row_, col_ + 1, code, 1);
+        if (tall)
+            set(row_ - 1, col_, code, 2);
+        if (wide && tall)
+            set(row_ - 1, col_ + 1, code, 3);
+
+        col_ += wide ? 2 : 1;
+        if (col_ > 40)
+        {
+            if (row_ == 0)
+            {
+                col_ = 40;
+                return;
+            }
+            col_ = 1;
+            if (++row_ > 24)
+                row_ = 1;
+        }
+    }
+};
+
+// ---------------------- Re-encoding -------------------------
+
+// Mosaic mask (MinitelGfx bits) of a G1 code
+uint8_t g1Mask(uint8_t code)
+{
+    if (code == 0x5F || code == 0x7F)
+        return 0x3F;
+    if (code >= 0x20 && code <= 0x3F)
+        return code - 0x20;
+    if (code >= 0x60 && code <= 0x7E)
+        return code - 0x40;
+    return 0;
+}
+
+// The current encoder, fed by the model's cells
+class Encoder
+{
+public:
+    uint32_t drcsCells = 0; // replayed as blanks
+    uint32_t textCells = 0; // same, without MGFX_TEXT_PLANE
+
+    Encoder() : gfx_(minitel_)
+    {
+        minitel_.begin(&port_);
+        gfx_.clear(true);
+        gfx_.flush();
+        minitel_.flushTx();
+        port_.reset();
+    }
+
+    size_t bytes() const { return port_.bytes; }
+    uint32_t hash() const { return port_.hash; }
+    uint32_t lostCells() const { return gfx_.lostCells(); }
+
+    // Bytes the diff from the last frame to `now` costs
+    size_t frame(const Screen &now)
+    {
+        for (uint8_t row = 0; row < 24; ++row)
+            for (uint8_t col = 0; col < 40; ++col)
+            {
+                const Cell &c = now.cells[row][col];
+                if (c != shown_.cells[row][col])
+                    draw(col, row, c);
+            }
+        shown_ = now;
+
+        size_t before = port_.bytes;
+        gfx_.flush();
+        minitel_.flushTx();
+        return port_.bytes - before;
+    }
+
+private:
+    MockStream port_;
+    Minitel minitel_;
+    MinitelGfx gfx_;
+    Screen shown_;
+
+    void draw(uint8_t col, uint8_t row, const Cell &c)
+    {
+        Minitel::Color bg = static_cast<Minitel::Color>(c.bg);
+        gfx_.fillCells(col, row, col, row, bg);
+        gfx_.setDrawBgColor(bg);
+        gfx_.setDrawColor(static_cast<Minitel::Color>(c.fg));
+
+        if (c.g1)
+        {
+            uint8_t mask = g1Mask(c.code);
+            for (uint8_t bit = 0; bit < 6; ++bit)
+                if (mask & (1u << bit))
+                    gfx_.drawPixel(col * 2 + bit % 2, row * 3 + bit / 2);
+            return;
+        }
+        if (c.drcs)
+        {
+            ++drcsCells;
+            return;
+        }
+#if MGFX_TEXT_PLANE
+        // Covered cells come with their character
+        if (c.part == 0 && c.code != 0x20)
+        {
+            gfx_.setTextAttributes(static_cast<Minitel::CharSize>(c.size),
+                                   c.negative, c.flash);
+            gfx_.drawChar(col, row, (char)c.code);
+        }
+#else
+        if (c.part == 0 && c.code != 0x20)
+            ++textCells;
+#endif
+    }
+};
+
+// ---------------------- Timeline -------------------------
+
+struct Frame
+{
+    double begin = 0, end = -1;   // flush() start / end, µs
+    double first = -1, last = -1; // port took the first / last byte
+    uint32_t from = 0;            // index of its first TX byte
+    uint32_t bytes = 0;
+    double blockedUs = 0;
+    size_t encoded = 0;           // bytes from this build's encoder
+    bool done = false;
+};
+
+struct Totals
+{
+    uint32_t frames = 0;
+    uint64_t bytes = 0, encoded = 0;
+    double flushUs = 0, flushMaxUs = 0;
+    double latencyUs = 0, latencyMaxUs = 0;
+    double blockedUs = 0;
+    uint32_t requests = 0, replies = 0, timeouts = 0;
+    double waitUs = 0, waitMaxUs = 0;
+    uint32_t tx = 0, rx = 0;
+};
+
+class Replay
+{
+public:
+    Totals totals;
+
+    Replay()
+    {
+        for (double &t : txnStart_)
+            t = -1;
+    }
+
+    void onTx(double t, uint8_t b)
+    {
+        screen_.feed(b);
+        uint32_t i = totals.tx++;
+        if (Frame *f = owner(i))
+        {
+            if (f->first < 0)
+                f->first = t;
+            f->last = t;
+            if (f->end >= 0 && i + 1 == f->from + f->bytes)
+                finish(*f);
+        }
+        prune();
+    }
+
+    void onRx(double, uint8_t) { ++totals.rx; }
+
+    void onMark(double t, uint8_t kind, uint16_t arg)
+    {
+        switch (kind)
+        {
+        case (uint8_t)Minitel::Trace::FlushBegin:
+        {
+            Frame f;
+            f.begin = t;
+            f.from = totals.tx + arg;
+            frames_.push_back(f);
+            break;
+        }
+        case (uint8_t)Minitel::Trace::FlushEnd:
+        {
+            Frame *f = open();
+            if (!f)
+                break;
+            f->end = t;
+            f->bytes = arg;
+            if (totals.tx >= f->from + f->bytes)
+                finish(*f);
+            prune();
+            break;
+        }
+        case (uint8_t)Minitel::Trace::TxnBegin:
+            if (arg < MINITEL_MAX_TRANSACTIONS)
+                txnStart_[arg] = t;
+            ++totals.requests;
+            break;
+        case (uint8_t)Minitel::Trace::TxnEnd:
+        {
+            uint8_t h = arg & 0xFF;
+            bool ok = arg & 0x100;
+            ok ? ++totals.replies : ++totals.timeouts;
+            if (h >= MINITEL_MAX_TRANSACTIONS || txnStart_[h] < 0)
+                break;
+            double wait = t - txnStart_[h];
+            txnStart_[h] = -1;
+            totals.waitUs += wait;
+            if (wait > totals.waitMaxUs)
+                totals.waitMaxUs = wait;
+            if (verbose)
+                printf("%10.1f  request %u %s after %.1f ms\n", t / 1000, h,
+                       ok ? "answered" : "timed out", wait / 1000);
+            break;
+        }
+        case MinitelRecorder::BLOCKED:
+            // Before the byte it was writing
+            totals.blockedUs += arg;
+            if (Frame *f = owner(totals.tx))
+                f->blockedUs += arg;
+            break;
+        default:
+            if (verbose && kind >= MinitelRecorder::USER)
+                printf("%10.1f  mark %u (%u)\n", t / 1000,
+                       kind - MinitelRecorder::USER, arg);
+            break;
+        }
+    }
+
+    // Frames whose bytes did not all make it into the recording
+    size_t unfinished() const { return frames_.size(); }
+
+    uint32_t drcsCells() const { return encoder_.drcsCells; }
+    uint32_t textCells() const { return encoder_.textCells; }
+    uint32_t lostCells() const { return encoder_.lostCells(); }
+    uint32_t encodedHash() const { return encoder_.hash(); }
+
+private:
+    Screen screen_;
+    Encoder encoder_;
+    std::vector<Frame> frames_; // oldest first, until done
+    double txnStart_[MINITEL_MAX_TRANSACTIONS];
+
+    // Frame TX byte i belongs to
+    Frame *owner(uint32_t i)
+    {
+        for (Frame &f : frames_)
+            if (!f.done && i >= f.from && (f.end < 0 || i < f.from + f.bytes))
+                return &f;
+        return nullptr;
+    }
+
+    Frame *open()
+    {
+        for (size_t k = frames_.size(); k-- > 0;)
+            if (frames_[k].end < 0)
+                return &frames_[k];
+        return nullptr;
+    }
+
+    void finish(Frame &f)
+    {
+        f.done = true;
+        f.encoded = encoder_.frame(screen_);
+
+        double flushUs = f.end - f.begin;
+        double latencyUs = (f.bytes ? f.last : f.end) - f.begin;
+        Totals &s = totals;
+        ++s.frames;
+        s.bytes += f.bytes;
+        s.encoded += f.encoded;
+        s.flushUs += flushUs;
+        s.latencyUs += latencyUs;
+        if (flushUs > s.flushMaxUs)
+            s.flushMaxUs = flushUs;
+        if (latencyUs > s.latencyMaxUs)
+            s.latencyMaxUs = latencyUs;
+
+        if (verbose)
+            printf("%10.1f  frame %-5u %8.0f %6u %9.1f %9.1f %9.1f %6zu\n",
+                   f.begin / 1000, s.frames, flushUs, f.bytes,
+                   f.bytes ? (f.first - f.begin) / 1000 : 0.0, latencyUs / 1000,
+                   f.blockedUs / 1000, f.encoded);
+    }
+
+    void prune()
+    {
+        while (!frames_.empty() && frames_.front().done)
+            frames_.erase(frames_.begin());
+    }
+};
+
+// ---------------------- Dump -------------------------
+
+uint16_t le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t le32(const uint8_t *p)
+{
+    return (uint32_t)le16(p) | ((uint32_t)le16(p + 2) << 16);
+}
+
+bool load(const char *path, std::vector<uint8_t> &data)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "replay: cannot open %s\n", path);
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(f);
+
+    // The dump may follow other output on the same serial port
+    static const uint8_t MAGIC[4] = {'M', 'R', 'E', 'C'};
+    for (size_t i = 0; i + MinitelRecorder::HEADER_BYTES <= data.size(); ++i)
+    {
+        if (memcmp(&data[i], MAGIC, 4) != 0)
+            continue;
+        data.erase(data.begin(), data.begin() + i);
+        if (data[4] != MinitelRecorder::VERSION || data[5] != 4)
+        {
+            fprintf(stderr, "replay: %s: unsupported version %u\n", path, data[4]);
+            return false;
+        }
+        return true;
+    }
+    fprintf(stderr, "replay: %s: no recording found\n", path);
+    return false;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    for (int a = 1; a < argc; ++a)
+    {
+        if (strcmp(argv[a], "-v") == 0)
+            verbose = true;
+        else
+            path = argv[a];
+    }
+    if (!path)
+    {
+        fprintf(stderr, "usage: replay [-v] recording\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (!load(path, data))
+        return 1;
+
+    uint16_t count = le16(&data[6]);
+    uint32_t dropped = le32(&data[8]);
+    size_t avail = (data.size() - MinitelRecorder::HEADER_BYTES) / 4;
+    if (avail < count)
+    {
+        fprintf(stderr, "replay: %s: %u records of %u\n", path, (unsigned)avail, count);
+        count = (uint16_t)avail;
+    }
+
+    if (verbose)
+        printf("%10s  %-11s %8s %6s %9s %9s %9s %6s\n", "ms", "", "flush us",
+               "bytes", "first ms", "last ms", "blocked", "now");
+
+    Replay replay;
+    const uint8_t *rec = &data[MinitelRecorder::HEADER_BYTES];
+    double t = 0;     // µs since the first record
+    uint32_t high = 0; // from a TIME record
+    for (uint16_t i = 0; i < count; ++i, rec += 4)
+    {
+        uint8_t kind = rec[0], value = rec[1];
+        uint16_t d = le16(rec + 2);
+        if (kind == MinitelRecorder::TIME)
+        {
+            high = d;
+            continue;
+        }
+        // An ARG whose MARK was dropped by the ring
+        if (kind == MinitelRecorder::ARG)
+            continue;
+        if (i > 0)
+            t += ((double)high * 65536.0) + d;
+        high = 0;
+
+        switch (kind)
+        {
+        case MinitelRecorder::TX:
+            replay.onTx(t, value);
+            break;
+        case MinitelRecorder::RX:
+            replay.onRx(t, value);
+            break;
+        case MinitelRecorder::MARK:
+        {
+            uint16_t arg = 0;
+            if (i + 1 < count && rec[4] == MinitelRecorder::ARG)
+            {
+                arg = le16(rec + 6);
+                ++i;
+                rec += 4;
+            }
+            replay.onMark(t, value, arg);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    const Totals &s = replay.totals;
+    printf("%s: %u records (%u dropped), %.1f ms, %u bytes out, %u in\n",
+           path, count, dropped, t / 1000, s.tx, s.rx);
+    if (s.frames)
+    {
+        printf("frames %u: flush %.0f us mean / %.0f max, last byte after "
+               "%.1f ms mean / %.1f max, blocked %.1f ms\n",
+               s.frames, s.flushUs / s.frames, s.flushMaxUs,
+               s.latencyUs / s.frames / 1000, s.latencyMaxUs / 1000,
+               s.blockedUs / 1000);
+        printf("bytes %llu recorded, %llu now (%+.1f%%), hash %08x\n",
+               (unsigned long long)s.bytes, (unsigned long long)s.encoded,
+               s.bytes ? 100.0 * ((double)s.encoded - s.bytes) / s.bytes : 0.0,
+               replay.encodedHash());
+    }
+    if (replay.unfinished())
+        printf("%zu frames not complete in the recording\n", replay.unfinished());
+    if (replay.drcsCells())
+        printf("%u DRCS cells replayed as blanks\n", replay.drcsCells());
+    if (replay.textCells())
+        printf("%u text cells replayed as blanks (no MGFX_TEXT_PLANE)\n",
+               replay.textCells());
+    if (replay.lostCells())
+        printf("%u cell writes lost by the compact shadow\n", replay.lostCells());
+    if (s.requests)
+        printf("requests %u: %u answered, %u timed out, wait %.1f ms mean / %.1f max\n",
+               s.requests, s.replies, s.timeouts,
+               (s.replies + s.timeouts) ? s.waitUs / (s.replies + s.timeouts) / 1000 : 0.0,
+               s.waitMaxUs / 1000);
+    return 0;
+}
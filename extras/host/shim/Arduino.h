@@ -0,0 +1,37 @@
+#pragma once
+
+// Minimal Arduino core for host builds: just what the library uses.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Print.h"
+#include "avr/pgmspace.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+// Time since start, from the host monotonic clock, plus whatever
+// hostAdvanceMillis() added (to run timeouts without waiting).
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void hostAdvanceMillis(unsigned long ms);
+
+// Pins do nothing; digitalRead() returns LOW (TP: terminal on)
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+void yield();
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+char *ltoa(long value, char *buf, int base);
+char *ultoa(unsigned long value, char *buf, int base);
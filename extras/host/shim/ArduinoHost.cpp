@@ -0,0 +1,72 @@
+#include <Arduino.h>
+
+#include <chrono>
+#include <thread>
+
+static unsigned long offsetMs = 0;
+
+static unsigned long long hostMicros()
+{
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(hostMicros() / 1000) + offsetMs;
+}
+
+unsigned long micros()
+{
+    return (unsigned long)hostMicros() + offsetMs * 1000UL;
+}
+
+void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void hostAdvanceMillis(unsigned long ms)
+{
+    offsetMs += ms;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+void yield() {}
+
+static char *toBase(unsigned long v, char *buf, int base, bool negative)
+{
+    char tmp[8 * sizeof(long) + 1];
+    int n = 0;
+    if (base < 2 || base > 36)
+        base = 10;
+    do
+    {
+        int d = v % base;
+        tmp[n++] = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+        v /= base;
+    } while (v);
+
+    char *p = buf;
+    if (negative)
+        *p++ = '-';
+    while (n)
+        *p++ = tmp[--n];
+    *p = '\0';
+    return buf;
+}
+
+char *ltoa(long value, char *buf, int base)
+{
+    if (base == 10 && value < 0)
+        return toBase(0UL - (unsigned long)value, buf, base, true);
+    return toBase((unsigned long)value, buf, base, false);
+}
+
+char *ultoa(unsigned long value, char *buf, int base)
+{
+    return toBase(value, buf, base, false);
+}
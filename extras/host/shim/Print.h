@@ -0,0 +1,87 @@
+#pragma once
+
+// Print / Stream as in the Arduino core, reduced to what the library
+// and the benchmarks use.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+            n += write(*buffer++);
+        return n;
+    }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char *s)
+    {
+        size_t n = 0;
+        while (*s)
+            n += write((uint8_t)*s++);
+        return n;
+    }
+    size_t print(const __FlashStringHelper *s)
+    {
+        return print(reinterpret_cast<const char *>(s));
+    }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned long v, int base = DEC) { return printNumber(v, base); }
+    size_t print(long v, int base = DEC)
+    {
+        if (base == DEC && v < 0)
+            return print('-') + printNumber(0UL - (unsigned long)v, base);
+        return printNumber((unsigned long)v, base);
+    }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+
+    size_t println() { return print("\r\n"); }
+    template <typename T>
+    size_t println(T v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(T v, int base) { return print(v, base) + println(); }
+
+private:
+    size_t printNumber(unsigned long v, int base)
+    {
+        char buf[8 * sizeof(long) + 1];
+        char *p = &buf[sizeof(buf) - 1];
+        *p = '\0';
+        if (base < 2)
+            base = 10;
+        do
+        {
+            int d = v % base;
+            *--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+            v /= base;
+        } while (v);
+        return print(p);
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
@@ -36,6 +36,10 @@ static const uint8_t C_RS  = 0x1E; // home
 static const uint8_t C_US  = 0x1F; // cursor position
 static const uint8_t C_DEL = 0x7F; // DELETE
 
+// ---- REP (repetition) ------------------------------------------------------
+static const uint8_t REP_THRESHOLD = 4;  // REP only pays for runs >= 4
+static const uint8_t MAX_REP_COUNT = 63; // count byte 0x40 + n
+
 // ---- STUM M1 SEP codes -----------------------------------------------------
 
 
@@ -55,13 +59,25 @@ static const uint8_t MOD_SOCKET_RX   = 0x5B; // 5/11
 
 static const uint8_t PRO3_CTRL_ON    = 0x61; // 6/1
 static const uint8_t PRO3_CTRL_OFF   = 0x60; // 6/0
+static const uint8_t PRO3_SWITCH_STATUS = 0x63; // 6/3, reply to 6/0 and 6/1
+
+static const uint8_t PRO2_START      = 0x69; // 6/9
+static const uint8_t PRO2_STOP       = 0x6A; // 6/A
+static const uint8_t MODE_ROLL       = 0x43; // 4/3
+static const uint8_t MODE_LOWERCASE  = 0x45; // 4/5
+static const uint8_t PRO2_MODE_STATUS = 0x73; // 7/3, REP STATUS FONCTIONNEMENT
+static const uint16_t ROLL_REPLY_TIMEOUT_MS = 500;
+
+static const uint8_t PRO1_SPEED_QUERY = 0x74; // 7/4, STATUS VITESSE
+static const uint8_t PRO2_SPEED_REPLY = 0x75; // 7/5, REP STATUS VITESSE
+static const uint8_t PRO2_PROG        = 0x6B; // 6/B, PROG + speed code
+static const uint16_t SPEED_TIMEOUT_MS = 500;  // for a timeout of 0
 
 // ----------------------------------------------------------------------------
 // Constructor / Setup
 // ----------------------------------------------------------------------------
 
 Minitel::Minitel() {
-    memset(eventBuf_, 0, sizeof(eventBuf_));
 }
 
 void Minitel::begin(Stream* stream, uint8_t ptPin, uint8_t tpPin, Stream* debug) {
@@ -70,6 +86,10 @@ void Minitel::begin(Stream* stream, uint8_t ptPin, uint8_t tpPin, Stream* debug)
     tpPin_  = tpPin;
     debug_  = debug;
 
+    // An idle port with no room is one that never reports any (Stream's
+    // default, e.g. SoftwareSerial): checking it would never drain
+    txCheckRoom_ = stream_ && stream_->availableForWrite() > 0;
+
     if (ptPin_ != 255) {
         pinMode(ptPin_, OUTPUT);
         digitalWrite(ptPin_, LOW);
@@ -126,11 +146,13 @@ bool Minitel::startSession(uint16_t timeoutMs) {
     // Blocking wait for SEP 5/4
     beginTransactionWaitSep(5, 4, timeoutMs);
     unsigned long start = millis();
-    while (tx_.active && (uint16_t)(millis() - start) <= timeoutMs) {
+    while (transactionState(legacyTxn_) == TransactionState::Pending &&
+           (uint16_t)(millis() - start) <= timeoutMs) {
         poll();
+        idle();
     }
 
-    if (!tx_.active && tx_.success) {
+    if (transactionSuccess()) {
         sessionState_ = SessionState::Open;
         return true;
     }
@@ -141,7 +163,156 @@ bool Minitel::startSession(uint16_t timeoutMs) {
     return false;
 }
 
+// ----------------------------------------------------------------------------
+// Boot sequencer
+// ----------------------------------------------------------------------------
+
+static void sendPRO3(Minitel& m, uint8_t control, uint8_t rx, uint8_t tx);
+
+void Minitel::beginTerminal(const TerminalConfig& cfg) {
+    bootCfg_  = cfg;
+    bootAcks_ = 0;
+    boot_     = BootState::Opening;
+    term_.roll = false;    // just switched on, or about to be reset
+
+    setPT(true);
+    sessionState_       = SessionState::Opening;
+    lastSessionEventMs_ = millis();
+    terminalOn_         = isTerminalOn();
+
+    if (ptPin_ == 255 || cfg.sessionTimeoutMs == 0 ||
+        beginTransaction(Response::sep(5, 4), cfg.sessionTimeoutMs, bootOnSession) < 0) {
+        // Nothing to wait for (or no room to): take the line as open
+        sessionState_ = SessionState::Open;
+        bootNegotiate();
+    }
+}
+
+void Minitel::bootOnSession(Minitel& m, int8_t, bool ok, const Event&, void*) {
+    if (!ok) {
+        m.sessionState_ = SessionState::Closed;
+        m.setPT(false);
+        m.bootFinish(false);
+        return;
+    }
+    m.bootNegotiate();
+}
+
+void Minitel::bootNegotiate() {
+    if (bootCfg_.baud != baud_) {
+        boot_ = BootState::Negotiating;
+        if (beginNegotiateSpeed(bootCfg_.baud, bootCfg_.ackTimeoutMs, bootOnSpeed)) return;
+    }
+    bootConfigure();
+}
+
+void Minitel::bootOnSpeed(Minitel& m, bool, uint32_t, void*) {
+    // Not fatal: the configuration goes out at whatever speed works
+    m.bootConfigure();
+}
+
+void Minitel::bootConfigure() {
+    const TerminalConfig& cfg = bootCfg_;
+    boot_ = BootState::Configuring;
+
+    // Everything goes out back to back: the terminal acknowledges the
+    // PRO3 commands while the first screen is still on the wire
+    if (cfg.keyboardToSocketOnly) {
+        configureKeyboardToSocketOnly();
+        bootAcks_ += 3;
+    }
+    sendPRO3(*this, cfg.localEcho ? PRO3_CTRL_ON : PRO3_CTRL_OFF,
+             MOD_SCREEN_RX, MOD_KEYBOARD_TX);
+    term_.echo = cfg.localEcho;
+    bootAcks_++;
+
+    // Answered by a REP STATUS FONCTIONNEMENT, after the PRO3 ones. Armed
+    // before sending, so it is claimed instead of read as input.
+    uint8_t pro2[] = { C_ESC, 0x3A, cfg.lowercase ? PRO2_START : PRO2_STOP, MODE_LOWERCASE };
+    bootStatus_ = beginTransaction(Response::pro2(PRO2_MODE_STATUS),
+                                   replyTimeout(cfg.ackTimeoutMs, sizeof(pro2)),
+                                   bootOnStatus) >= 0;
+    writeRaw(pro2, sizeof(pro2));
+    writeRaw(cfg.cursorVisible ? C_Con : C_Coff);
+
+    if (cfg.clearScreen) clearScreen();
+    if (cfg.firstScreen) cfg.firstScreen(*this, cfg.ctx);
+
+    bootArmAck();
+}
+
+void Minitel::bootArmAck() {
+    if (bootAcks_ == 0) {
+        if (!bootStatus_) bootFinish(true);
+        return;
+    }
+    // Replies come in command order: one transaction at a time is enough
+    if (beginTransaction(Response::pro3(PRO3_SWITCH_STATUS),
+                         replyTimeout(bootCfg_.ackTimeoutMs, 0), bootOnAck) < 0) {
+        bootFinish(false);
+    }
+}
+
+void Minitel::bootOnAck(Minitel& m, int8_t, bool ok, const Event&, void*) {
+    // The status reply may have failed the boot already
+    if (m.boot_ != BootState::Configuring) return;
+    if (!ok) {
+        // The others are not coming either
+        m.bootFinish(false);
+        return;
+    }
+    m.bootAcks_--;
+    m.bootArmAck();
+}
+
+void Minitel::bootOnStatus(Minitel& m, int8_t, bool ok, const Event&, void*) {
+    if (m.boot_ != BootState::Configuring) return;
+    m.bootStatus_ = false;
+    if (!ok) {
+        m.bootFinish(false);
+    } else if (m.bootAcks_ == 0) {
+        m.bootFinish(true);
+    }
+}
+
+void Minitel::bootFinish(bool ok) {
+    bootAcks_   = 0;
+    bootStatus_ = false;
+    boot_ = ok ? BootState::Ready : BootState::Failed;
+    if (bootCfg_.onReady) bootCfg_.onReady(*this, ok, bootCfg_.ctx);
+}
+
+void Minitel::checkTerminalPower() {
+    if (tpPin_ == 255 || boot_ == BootState::Idle) return;
+    bool on = isTerminalOn();
+    if (on == terminalOn_) return;
+    terminalOn_ = on;
+
+    // Drop what the previous boot was waiting for
+    for (uint8_t i = 0; i < MINITEL_MAX_TRANSACTIONS; ++i) {
+        TransactionCallback cb = txns_[i].callback;
+        if (cb == bootOnSession || cb == bootOnAck || cb == bootOnStatus ||
+            cb == speedOnReply) {
+            txns_[i] = Transaction();
+        }
+    }
+    if (speedStep_ != SPEED_IDLE) {
+        speedStep_ = SPEED_IDLE;
+        // The boot's own negotiation starts over with it; others are told
+        if (speedCb_ && speedCb_ != bootOnSpeed) speedCb_(*this, false, baud_, speedCtx_);
+    }
+
+    if (!on) {
+        sessionState_ = SessionState::Closed;
+        return;
+    }
+    // Switched back on: it starts over at 1200 bauds, unconfigured
+    if (baud_ != 1200 && baudSetter_) speedSwitch(1200);
+    beginTerminal(bootCfg_);
+}
+
 void Minitel::endSession() {
+    flushTx();
     setPT(false);
     sessionState_       = SessionState::Closed;
     lastSessionEventMs_ = millis();
@@ -152,41 +323,238 @@ bool Minitel::isTerminalOn() const {
     return (digitalRead(tpPin_) == LOW); // TP low => ON in STUM
 }
 
+// ----------------------------------------------------------------------------
+// Line speed (PROG)
+// ----------------------------------------------------------------------------
+
+// Speed codes of PROG and REP STATUS VITESSE: 0x40 | tx << 3 | rx
+static uint8_t speedCode(uint32_t baud) {
+    switch (baud) {
+    case 300:  return 2;
+    case 1200: return 4;
+    case 4800: return 6;
+    case 9600: return 7;
+    default:   return 0;
+    }
+}
+
+static uint32_t speedFromStatus(uint8_t status) {
+    static const uint32_t BAUDS[8] = { 0, 0, 300, 0, 1200, 0, 4800, 9600 };
+    return BAUDS[status & 0x07];
+}
+
+// Same speed both ways
+static void sendPROG(Minitel& m, uint32_t baud) {
+    uint8_t code = speedCode(baud);
+    const uint8_t prog[] = { C_ESC, 0x3A, PRO2_PROG, (uint8_t)(0x40 | (code << 3) | code) };
+    m.writeRaw(prog, sizeof(prog));
+}
+
+void Minitel::setBaudSetter(BaudSetter fn, void* ctx) {
+    baudSetter_    = fn;
+    baudSetterCtx_ = ctx;
+}
+
+bool Minitel::beginNegotiateSpeed(uint32_t baud, uint16_t timeoutMs,
+                                  SpeedCallback cb, void* ctx) {
+    if (!stream_ || !baudSetter_ || speedCode(baud) == 0 || speedStep_ != SPEED_IDLE) {
+        return false;
+    }
+
+    speedTarget_    = baud;
+    speedPrev_      = baud_;
+    // 0 would never time out: a silent terminal would keep it running
+    speedTimeoutMs_ = timeoutMs ? timeoutMs : SPEED_TIMEOUT_MS;
+    speedCb_        = cb;
+    speedCtx_       = ctx;
+    speedStep_      = SPEED_QUERY;
+    speedQuery();
+    return true;
+}
+
+bool Minitel::negotiateSpeed(uint32_t baud, uint16_t timeoutMs) {
+    if (!beginNegotiateSpeed(baud, timeoutMs)) return false;
+    while (speedStep_ != SPEED_IDLE) {
+        poll();
+        idle();
+    }
+    return baud_ == baud;
+}
+
+void Minitel::speedQuery() {
+    const uint8_t query[] = { C_ESC, 0x39, PRO1_SPEED_QUERY };
+    if (sendRequest(query, sizeof(query), Response::pro2(PRO2_SPEED_REPLY),
+                    speedTimeoutMs_, speedOnReply) < 0) {
+        speedFinish(false);
+    }
+}
+
+void Minitel::speedSwitch(uint32_t baud) {
+    if (!stream_ || !baudSetter_) return;
+
+    // Everything queued must leave at the old speed
+    flushTx();
+    stream_->flush();
+    baudSetter_(baud, baudSetterCtx_);
+    setBaudRate(baud);
+
+    // Whatever came in during the switch is noise
+    while (stream_->available()) stream_->read();
+    escState_         = ESC_IDLE;
+    waitingSepSecond_ = false;
+    usState_          = 0;
+}
+
+void Minitel::speedOnReply(Minitel& m, int8_t, bool ok, const Event& reply, void*) {
+    uint32_t heard = ok ? speedFromStatus(reply.escData[1]) : 0;
+
+    switch (m.speedStep_) {
+    case SPEED_QUERY:
+        if (!ok) {
+            // No STATUS VITESSE: no PROG either
+            m.speedFinish(false);
+        } else if (heard == m.speedTarget_) {
+            // Already there, by the terminal's own account (heard at
+            // all, so the port runs at that speed too)
+            m.setBaudRate(heard);
+            m.speedFinish(true);
+        } else {
+            sendPROG(m, m.speedTarget_);
+            m.speedSwitch(m.speedTarget_);
+            m.speedStep_ = SPEED_VERIFY;
+            m.speedQuery();
+        }
+        break;
+
+    case SPEED_VERIFY:
+        if (heard == m.speedTarget_) {
+            m.speedFinish(true);
+        } else {
+            // The terminal may have switched without us hearing it: ask
+            // it back, then go back ourselves
+            sendPROG(m, m.speedPrev_);
+            m.speedSwitch(m.speedPrev_);
+            m.speedStep_ = SPEED_FALLBACK;
+            m.speedQuery();
+        }
+        break;
+
+    default:
+        m.speedFinish(false);
+        break;
+    }
+}
+
+void Minitel::speedFinish(bool ok) {
+    speedStep_ = SPEED_IDLE;
+    if (speedCb_) speedCb_(*this, ok, baud_, speedCtx_);
+}
+
 // ----------------------------------------------------------------------------
 // Unified event FIFO
 // ----------------------------------------------------------------------------
 
+MinitelPackedEvent Minitel::packEvent(const Event& ev) {
+    MinitelPackedEvent p;
+    if (ev.type == Event::ESCSEQ && ev.code >= 0x39 && ev.code <= 0x3B &&
+        ev.escLen == ev.code - 0x38) {
+        // ESC 3/9..3/B + 1..3 bytes: the length tells the opcode
+        p.type = ev.type | MinitelPackedEvent::PACKED_SEQ | (ev.escLen << 5);
+        for (uint8_t i = 0; i < 3; ++i) p.data[i] = (i < ev.escLen) ? ev.escData[i] : 0;
+    } else if (ev.type == Event::POSITION) {
+        p.type = ev.type | MinitelPackedEvent::PACKED_SEQ | (2 << 5);
+        p.data[0] = ev.row;
+        p.data[1] = ev.col;
+        p.data[2] = 0;
+    } else {
+        p.type    = ev.type;
+        p.data[0] = ev.code;
+        p.data[1] = 1;
+        p.data[2] = 0;
+    }
+    return p;
+}
+
+Minitel::Event Minitel::unpackEvent(const MinitelPackedEvent& p) {
+    Event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = static_cast<Event::Type>(p.type & MinitelPackedEvent::TYPE_MASK);
+
+    if (ev.type == Event::POSITION) {
+        ev.row = p.data[0];
+        ev.col = p.data[1];
+    } else if (p.isSeq()) {
+        ev.escLen = p.seqLen();
+        ev.code   = 0x38 + ev.escLen;
+        for (uint8_t i = 0; i < ev.escLen; ++i) ev.escData[i] = p.data[i];
+    } else {
+        ev.code = p.data[0];
+        if (ev.type == Event::SEP) {
+            ev.row = (ev.code >> 4) & 0x07;
+            ev.col = ev.code & 0x0F;
+        }
+    }
+    return ev;
+}
+
 bool Minitel::eventAvailable() const {
-    return eventHead_ != eventTail_;
+    return !events_.empty();
 }
 
 bool Minitel::readEvent(Event& ev) {
-    if (eventHead_ == eventTail_) return false;
-    ev = eventBuf_[eventTail_];
-    eventTail_ = (uint8_t)((eventTail_ + 1) % EVENTBUF_SIZE);
+    MinitelPackedEvent p;
+    if (!events_.consumeOne(p)) return false;
+    ev = unpackEvent(p);
     return true;
 }
 
-void Minitel::pushEvent(const Event& ev) {
-    uint8_t next = (uint8_t)((eventHead_ + 1) % EVENTBUF_SIZE);
-    if (next == eventTail_) {
-        // overflow: drop oldest
-        eventTail_ = (uint8_t)((eventTail_ + 1) % EVENTBUF_SIZE);
-    }
-    eventBuf_[eventHead_] = ev;
-    eventHead_ = next;
+bool Minitel::queueEvent(const Event& ev, OverflowPolicy policy) {
+    stats_.events++;
+    if (events_.push(packEvent(ev), policy)) return true;
+    stats_.eventOverflows++;
+    return false;
+}
 
-    if (debug_) {
-        debug_->print(F("EV "));
-        debug_->print((int)ev.type);
-        debug_->print(F(" code=0x"));
-        if (ev.code < 0x10) debug_->print('0');
-        debug_->print(ev.code, HEX);
-        debug_->print(F(" row="));
-        debug_->print(ev.row);
-        debug_->print(F(" col="));
-        debug_->println(ev.col);
+namespace {
+// Interrupts off for a scope, then back as they were (not just on: the
+// caller may have had them off)
+class InterruptLock {
+public:
+#if defined(__AVR__)
+    InterruptLock() : sreg_(SREG) { cli(); }
+    ~InterruptLock() { SREG = sreg_; }
+private:
+    uint8_t sreg_;
+#elif defined(__arm__) && defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+    InterruptLock() {
+        __asm__ __volatile__("mrs %0, primask\n\tcpsid i" : "=r"(primask_) :: "memory");
+    }
+    ~InterruptLock() {
+        __asm__ __volatile__("msr primask, %0" :: "r"(primask_) : "memory");
     }
+private:
+    uint32_t primask_;
+#else
+    InterruptLock() { noInterrupts(); }
+    ~InterruptLock() { interrupts(); }
+#endif
+};
+}
+
+void Minitel::pushEvent(const Event& ev) {
+    // A reply a transaction waits for goes to that transaction only
+    if (claimReply(ev)) return;
+
+    // pushEventFromISR() may be the other producer
+    InterruptLock lock;
+    queueEvent(ev, events_.policy());
+}
+
+bool Minitel::pushEventFromISR(const Event& ev) {
+    // DropOld would move tail_ under the consumer's feet
+    OverflowPolicy policy = events_.policy();
+    if (policy == OverflowPolicy::DropOld) policy = OverflowPolicy::DropNew;
+    return queueEvent(ev, policy);
 }
 
 // ----------------------------------------------------------------------------
@@ -196,13 +564,26 @@ void Minitel::pushEvent(const Event& ev) {
 void Minitel::writeRaw(uint8_t b) {
     if (!stream_) return;
     uint8_t v = b & 0x7F;
-    if (debug_) {
-        debug_->print(F("TX "));
-        if (v < 0x10) debug_->print('0');
-        debug_->print(v, HEX);
-        debug_->print(' ');
+    trackTx(v);
+
+#if MINITEL_TX_QUEUE_SIZE > 0
+    if (txCount_ == 0 && (!txCheckRoom_ || stream_->availableForWrite() > 0)) {
+        // Nothing ahead of it and room in the port: no need to queue
+        stream_->write(v);
+        return;
     }
+    if (txCount_ >= MINITEL_TX_QUEUE_SIZE) {
+        // Queue full: make room the blocking way
+        stream_->write(txBuf_[txTail_]);
+        txTail_ = (uint16_t)((txTail_ + 1) % MINITEL_TX_QUEUE_SIZE);
+        txCount_--;
+    }
+    txBuf_[txHead_] = v;
+    txHead_ = (uint16_t)((txHead_ + 1) % MINITEL_TX_QUEUE_SIZE);
+    txCount_++;
+#else
     stream_->write(v);
+#endif
 }
 
 void Minitel::writeRaw(const uint8_t* data, size_t len) {
@@ -211,6 +592,368 @@ void Minitel::writeRaw(const uint8_t* data, size_t len) {
     }
 }
 
+void Minitel::writeProgmem(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        writeRaw(pgm_read_byte(data + i));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// TX queue
+// ----------------------------------------------------------------------------
+
+uint16_t Minitel::drainTx(uint16_t maxBytes) {
+#if MINITEL_TX_QUEUE_SIZE > 0
+    if (!stream_) return 0;
+
+    uint16_t n = (txCount_ < maxBytes) ? txCount_ : maxBytes;
+    if (txCheckRoom_ && n > 0) {
+        int room = stream_->availableForWrite();
+        if (room < 0) room = 0;
+        if ((uint16_t)room < n) n = (uint16_t)room;
+    }
+
+    for (uint16_t i = 0; i < n; ++i) {
+        stream_->write(txBuf_[txTail_]);
+        txTail_ = (uint16_t)((txTail_ + 1) % MINITEL_TX_QUEUE_SIZE);
+    }
+    txCount_ -= n;
+    return n;
+#else
+    (void)maxBytes;
+    return 0;
+#endif
+}
+
+void Minitel::flushTx() {
+#if MINITEL_TX_QUEUE_SIZE > 0
+    if (!stream_) return;
+    while (txCount_ > 0) {
+        stream_->write(txBuf_[txTail_]);
+        txTail_ = (uint16_t)((txTail_ + 1) % MINITEL_TX_QUEUE_SIZE);
+        txCount_--;
+    }
+#endif
+}
+
+uint16_t Minitel::txQueued() const {
+#if MINITEL_TX_QUEUE_SIZE > 0
+    return txCount_;
+#else
+    return 0;
+#endif
+}
+
+uint16_t Minitel::txFree() const {
+#if MINITEL_TX_QUEUE_SIZE > 0
+    return MINITEL_TX_QUEUE_SIZE - txCount_;
+#else
+    return 0xFFFF;
+#endif
+}
+
+uint32_t Minitel::txDrainTimeMs() const {
+    // 7E1: start + 7 data + parity + stop = 10 bits per char
+    return ((uint32_t)txQueued() * 10UL * 1000UL + baud_ - 1) / baud_;
+}
+
+uint16_t Minitel::replyTimeout(uint16_t timeoutMs, uint16_t sending) const {
+    // The timer starts now, but the terminal only sees the command once
+    // the queue ahead of it and the command itself are on the wire
+    if (timeoutMs == 0) return 0;
+    uint32_t ms = timeoutMs + ((uint32_t)(txQueued() + sending) * 10UL * 1000UL + baud_ - 1) / baud_;
+    return (ms > 0xFFFF) ? 0xFFFF : (uint16_t)ms;
+}
+
+// ----------------------------------------------------------------------------
+// Statistics
+// ----------------------------------------------------------------------------
+
+void Minitel::countCells(uint16_t cells, bool flush) {
+    stats_.cellsChanged += cells;
+    if (flush) stats_.flushes++;
+}
+
+void Minitel::dumpStats(Print* out) const {
+    if (!out) out = debug_;
+    if (!out) return;
+
+    out->print(F("TX "));
+    out->print(stats_.txTotal());
+    out->print(F(": cursor "));
+    out->print(stats_.txCursor);
+    out->print(F(" attr "));
+    out->print(stats_.txAttr);
+    out->print(F(" rep "));
+    out->print(stats_.txRep);
+    out->print(F(" payload "));
+    out->print(stats_.txPayload);
+    out->print(F(" control "));
+    out->println(stats_.txControl);
+
+    out->print(F("RX "));
+    out->print(stats_.rxBytes);
+    out->print(F(": events "));
+    out->print(stats_.events);
+    out->print(F(" overflows "));
+    out->print(stats_.eventOverflows);
+    out->print(F(" parse errors "));
+    out->println(stats_.parseErrors);
+
+    out->print(F("flushes "));
+    out->print(stats_.flushes);
+    out->print(F(" cells "));
+    out->print(stats_.cellsChanged);
+    out->print(F(" transaction timeouts "));
+    out->println(stats_.transactionTimeouts);
+}
+
+// ----------------------------------------------------------------------------
+// Terminal state shadow
+// ----------------------------------------------------------------------------
+
+void Minitel::invalidateTermState() {
+    term_.attrsKnown  = false;
+    term_.cursorKnown = false;
+}
+
+void Minitel::resetAttributes() {
+    // STUM: US / RS / FF restore the default attributes
+    term_.charset    = CharSet::G0_ALPHA;
+    term_.fg         = Color::White;
+    term_.bg         = Color::Black;
+    term_.flash      = false;
+    term_.negative   = false;
+    term_.size       = CharSize::Normal;
+    term_.attrsKnown = true;
+}
+
+void Minitel::advanceCursor(uint8_t count) {
+    if (!term_.cursorKnown) return;
+
+    if (term_.row == 0) {
+        // Row 00 does not wrap: stay on the last column
+        uint16_t c = term_.col + count;
+        term_.col = (c > 40) ? 40 : (uint8_t)c;
+        return;
+    }
+
+    uint16_t c = term_.col + count;
+    while (c > 40) {
+        c -= 40;
+        if (term_.row >= 24) {
+            // Page mode wraps to the top: don't rely on it
+            term_.cursorKnown = false;
+            return;
+        }
+        term_.row++;
+    }
+    term_.col = (uint8_t)c;
+}
+
+void Minitel::trackTx(uint8_t b) {
+    switch (txSeq_) {
+    case TXS_NONE:
+        break;
+
+    case TXS_ESC:
+        // The ESC itself is counted with what it introduces
+        txSeq_ = TXS_NONE;
+        if (b == 0x5B) {
+            stats_.txCursor += 2;
+        } else if (b >= 0x40 && b <= 0x5F) {
+            stats_.txAttr += 2;
+        } else {
+            stats_.txControl += 2;
+        }
+
+        if (b >= 0x40 && b <= 0x47) {
+            term_.fg = static_cast<Color>(b & 0x07);
+        } else if (b >= 0x50 && b <= 0x57) {
+            term_.bg = static_cast<Color>(b & 0x07);
+        } else if (b == 0x48 || b == 0x49) {
+            term_.flash = (b == 0x48);
+        } else if (b >= 0x4C && b <= 0x4F) {
+            term_.size = static_cast<CharSize>(b - 0x4C);
+        } else if (b == 0x5C || b == 0x5D) {
+            term_.negative = (b == 0x5D);
+        } else if (b >= 0x39 && b <= 0x3B) {
+            // PRO1 / PRO2 / PRO3: 1..3 argument bytes, no screen effect
+            txSeq_ = TXS_SKIP;
+            txArg_ = b - 0x38;
+        } else if (b == 0x5B) {
+            txSeq_ = TXS_CSI;
+        } else if (b >= 0x28 && b <= 0x2B) {
+            // Charset designation: G0..G3, an optional SP (DRCS), the set
+            txSeq_ = TXS_DESIGNATE;
+            txArg_ = b;
+        }
+        return;
+
+    case TXS_DESIGNATE:
+        stats_.txControl++;
+        if (b == 0x20) {
+            txArg_ |= 0x80;
+            return;
+        }
+        txSeq_ = TXS_NONE;
+        if ((txArg_ & 0x7F) == 0x28) {
+            term_.drcs = (txArg_ & 0x80) && b == 0x42;
+        }
+        return;
+
+    case TXS_DRCS:
+        // Shapes until the next US, which is handled as usual
+        if (b != C_US) {
+            stats_.txControl++;
+            return;
+        }
+        txSeq_ = TXS_NONE;
+        break;
+
+    case TXS_CSI:
+        // CSI parameters until the final byte; cursor is then unknown
+        stats_.txCursor++;
+        if (b >= 0x40) {
+            txSeq_ = TXS_NONE;
+            term_.cursorKnown = false;
+        }
+        return;
+
+    case TXS_US_ROW:
+        if (b == 0x23) {
+            // DRCS loading, not a position
+            stats_.txControl++;
+            txSeq_ = TXS_DRCS;
+            term_.cursorKnown = false;
+            return;
+        }
+        stats_.txCursor++;
+        txArg_ = b;
+        txSeq_ = TXS_US_COL;
+        return;
+
+    case TXS_US_COL:
+        stats_.txCursor++;
+        txSeq_ = TXS_NONE;
+        if (txArg_ == 0x40) {
+            // Row 00 access: the LF leaving it restores this state
+            if (term_.row != 0) row0Saved_ = term_;
+            resetAttributes();
+            term_.row = 0;
+            term_.col = (b > 0x40) ? (b & 0x3F) : 1;
+            term_.cursorKnown = true;
+        } else if (txArg_ > 0x40 && txArg_ <= 0x58 && b > 0x40 && b <= 0x68) {
+            resetAttributes();
+            term_.row = txArg_ & 0x3F;
+            term_.col = b & 0x3F;
+            term_.cursorKnown = true;
+        } else {
+            // Decimal form or out of range: let the terminal sort it out
+            resetAttributes();
+            term_.cursorKnown = false;
+        }
+        return;
+
+    case TXS_REP: {
+        stats_.txRep++;
+        txSeq_ = TXS_NONE;
+        bool wide = term_.charset == CharSet::G0_ALPHA &&
+                    (term_.size == CharSize::DoubleWidth ||
+                     term_.size == CharSize::DoubleSize);
+        advanceCursor((uint8_t)((b & 0x3F) * (wide ? 2 : 1)));
+        return;
+    }
+
+    case TXS_SKIP:
+        stats_.txControl++;
+        if (--txArg_ == 0) txSeq_ = TXS_NONE;
+        return;
+    }
+
+    if (b >= 0x20) {
+        stats_.txPayload++;
+        bool wide = term_.charset == CharSet::G0_ALPHA &&
+                    (term_.size == CharSize::DoubleWidth ||
+                     term_.size == CharSize::DoubleSize);
+        advanceCursor(wide ? 2 : 1);
+        return;
+    }
+
+    switch (b) {
+    case C_ESC:
+        break;
+    case C_US: case C_BS: case C_HT: case C_LF: case C_VT: case C_CR: case C_RS:
+        stats_.txCursor++;
+        break;
+    case C_REP:
+        stats_.txRep++;
+        break;
+    case C_SO: case C_SI:
+        stats_.txAttr++;
+        break;
+    default:
+        stats_.txControl++;
+        break;
+    }
+
+    switch (b) {
+    case C_ESC: txSeq_ = TXS_ESC;    break;
+    case C_US:  txSeq_ = TXS_US_ROW; break;
+    case C_REP: txSeq_ = TXS_REP;    break;
+
+    case C_SO:
+        // G1 has no size or polarity
+        term_.charset  = CharSet::G1_GRAPHIC;
+        term_.size     = CharSize::Normal;
+        term_.negative = false;
+        break;
+    case C_SI:
+        term_.charset = CharSet::G0_ALPHA;
+        break;
+
+    case C_FF:
+    case C_RS:
+        resetAttributes();
+        term_.row = 1;
+        term_.col = 1;
+        term_.cursorKnown = true;
+        break;
+
+    case C_CR:
+        term_.col = 1;
+        break;
+    case C_BS:
+        if (term_.col > 1) term_.col--;
+        else term_.cursorKnown = false;
+        break;
+    case C_HT:
+        if (term_.col < 40) term_.col++;
+        else term_.cursorKnown = false;
+        break;
+    case C_LF:
+        if (term_.row == 0) {
+            // Leaving row 00 restores position and attributes (the
+            // designated sets stay)
+            bool drcs = term_.drcs;
+            term_ = row0Saved_;
+            term_.drcs = drcs;
+        } else if (term_.row < 24) {
+            term_.row++;
+        } else if (!term_.roll) {
+            term_.cursorKnown = false;
+        }
+        break;
+    case C_VT:
+        if (term_.row > 1) term_.row--;
+        else if (!term_.roll) term_.cursorKnown = false;
+        break;
+
+    default:
+        break;
+    }
+}
+
 // ----------------------------------------------------------------------------
 // ESC / SEP parsing
 // ----------------------------------------------------------------------------
@@ -219,9 +962,6 @@ void Minitel::handleSep(uint8_t secondByte) {
     uint8_t row = (secondByte >> 4) & 0x07;
     uint8_t col = (secondByte & 0x0F);
 
-    // Transaction hook: SEP-based ack
-    onSepForTransaction(row, col);
-
     // Session management: SEP 5/4
     if (row == 5 && col == 4) {
         if (sessionState_ == SessionState::Opening) {
@@ -248,9 +988,10 @@ void Minitel::handleEscByte(uint8_t c) {
         break;
 
     case ESC_GOT_ESC:
-        if (c == 0x3B) {
-            // ESC 3B a b c → PRO3-like sequence (3 bytes)
-            escState_  = ESC_3B;
+        if (c >= 0x39 && c <= 0x3B) {
+            // ESC 39 a / 3A a b / 3B a b c → PRO1..PRO3-like replies
+            escState_  = ESC_PRO;
+            escCode_  = c;
             escTmpLen_ = 0;
         } else if (c >= 0x40 && c <= 0x7F) {
             // Single-byte C1 after ESC
@@ -265,24 +1006,22 @@ void Minitel::handleEscByte(uint8_t c) {
             escState_ = ESC_IDLE;
         } else {
             // Unknown / unsupported => drop
+            stats_.parseErrors++;
             escState_ = ESC_IDLE;
         }
         break;
 
-    case ESC_3B:
+    case ESC_PRO:
         escTmp_[escTmpLen_++] = c;
-        if (escTmpLen_ >= 3) {
+        if (escTmpLen_ >= escCode_ - 0x38) {
             Event ev;
             ev.type   = Event::ESCSEQ;
-            ev.code   = 0x3B; // ESC 3B ...
+            ev.code   = escCode_; // ESC 3x ...
             ev.row    = 0;
             ev.col    = 0;
-            ev.escLen = 3;
-            for (uint8_t i = 0; i < 3; ++i) {
-                ev.escData[i] = escTmp_[i] & 0x7F;
-            }
-            for (uint8_t i = 3; i < sizeof(ev.escData); ++i) {
-                ev.escData[i] = 0;
+            ev.escLen = escTmpLen_;
+            for (uint8_t i = 0; i < sizeof(ev.escData); ++i) {
+                ev.escData[i] = (i < escTmpLen_) ? escTmp_[i] & 0x7F : 0;
             }
             pushEvent(ev);
             escState_  = ESC_IDLE;
@@ -301,14 +1040,8 @@ bool Minitel::handleLineEditingControl(uint8_t c) {
         case C_HT:  // Horizontal Tab (Cursor Right)
         case C_VT:  // Vertical Tab (Cursor Up)
         case C_RS:  // Home Cursor
-        case C_US:  // Cursor Position prefix
         case C_CAN: // Cancel/Clear Line
         case C_DEL: // Delete (7F)
-            if (debug_) {
-                debug_->print(F("CONTROL 0x"));
-                debug_->print(c, HEX);
-                debug_->println(F(" consumed."));
-            }
             return true;
         default:
             return false;
@@ -331,12 +1064,35 @@ void Minitel::parseByte(uint8_t c) {
         return;
     }
 
-    // 3. Complex navigation/editing controls (consumed)
+    // 3. US row col: reply to a cursor position request (ESC 6/1)
+    if (usState_ != 0) {
+        if (usState_ == 1) {
+            usRow_   = c;
+            usState_ = 2;
+            return;
+        }
+        usState_ = 0;
+
+        Event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.type = Event::POSITION;
+        ev.row  = usRow_ & 0x3F;
+        ev.col  = c & 0x3F;
+        pushEvent(ev);
+        return;
+    }
+    if (c == C_US) {
+        usState_ = 1;
+        return;
+    }
+
+    // 4. Complex navigation/editing controls (consumed)
     if (handleLineEditingControl(c)) {
+        if (term_.echo) term_.cursorKnown = false;
         return;
     }
 
-    // 4. Start ESC or SEP sequence
+    // 5. Start ESC or SEP sequence
     if (c == C_ESC) {
         escState_ = ESC_GOT_ESC;
         return;
@@ -346,8 +1102,10 @@ void Minitel::parseByte(uint8_t c) {
         return;
     }
 
-    // 5. Explicitly classified C0 Controls (CR, LF, BS must be Event::CHAR for readLine)
+    // 6. Explicitly classified C0 Controls (CR, LF, BS must be Event::CHAR for readLine)
     if (c == C_CR || c == C_LF || c == C_BS) {
+        // Echoed locally, the keystroke moved the cursor too
+        if (term_.echo) term_.cursorKnown = false;
         Event ev;
         ev.type = Event::CHAR;
         ev.code = c;
@@ -355,7 +1113,7 @@ void Minitel::parseByte(uint8_t c) {
         return;
     }
 
-    // 6. Other C0 Controls (0x00 to 0x1F, excluding exceptions above)
+    // 7. Other C0 Controls (0x00 to 0x1F, excluding exceptions above)
     if (c < 0x20) {
         Event ev;
         ev.type = Event::CONTROL;
@@ -364,8 +1122,9 @@ void Minitel::parseByte(uint8_t c) {
         return;
     }
 
-    // 7. Printable Characters (0x20..0x7E)
+    // 8. Printable Characters (0x20..0x7E)
     if (c >= 0x20 && c <= 0x7E) {
+        if (term_.echo) term_.cursorKnown = false;
         Event ev;
         ev.type = Event::CHAR;
         ev.code = c;
@@ -378,31 +1137,127 @@ void Minitel::parseByte(uint8_t c) {
 // Transaction helpers
 // ----------------------------------------------------------------------------
 
+int8_t Minitel::beginTransaction(const Response& expect, uint16_t timeoutMs,
+                                 TransactionCallback cb, void* ctx) {
+    for (uint8_t i = 0; i < MINITEL_MAX_TRANSACTIONS; ++i) {
+        Transaction& t = txns_[i];
+        if (t.state != TransactionState::Free) continue;
+
+        t.state     = TransactionState::Pending;
+        t.expect    = expect;
+        t.order     = txnOrder_++;
+        t.timeoutMs = timeoutMs;
+        t.startTime = millis();
+        t.callback  = cb;
+        t.ctx       = ctx;
+        memset(&t.reply, 0, sizeof(t.reply));
+        trace(Trace::TxnBegin, i);
+        return (int8_t)i;
+    }
+    return -1;
+}
+
+int8_t Minitel::sendRequest(const uint8_t* cmd, uint8_t len, const Response& expect,
+                            uint16_t timeoutMs, TransactionCallback cb, void* ctx) {
+    // Armed before sending, so no reply can come first
+    int8_t h = beginTransaction(expect, replyTimeout(timeoutMs, len), cb, ctx);
+    if (h >= 0) writeRaw(cmd, len);
+    return h;
+}
+
+Minitel::TransactionState Minitel::transactionState(int8_t h) const {
+    if (h < 0 || h >= MINITEL_MAX_TRANSACTIONS) return TransactionState::Free;
+    return txns_[h].state;
+}
+
+bool Minitel::transactionReply(int8_t h, Event& reply) const {
+    if (transactionState(h) != TransactionState::Done) return false;
+    reply = txns_[h].reply;
+    return true;
+}
+
+void Minitel::endTransaction(int8_t h) {
+    if (h < 0 || h >= MINITEL_MAX_TRANSACTIONS) return;
+    txns_[h].state = TransactionState::Free;
+}
+
+bool Minitel::waitTransaction(int8_t h) {
+    while (transactionState(h) == TransactionState::Pending) {
+        poll();
+        idle();
+    }
+    return transactionState(h) == TransactionState::Done;
+}
+
+uint8_t Minitel::transactionsPending() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < MINITEL_MAX_TRANSACTIONS; ++i) {
+        if (txns_[i].state == TransactionState::Pending) n++;
+    }
+    return n;
+}
+
 void Minitel::beginTransactionWaitSep(uint8_t row, uint8_t col, uint16_t timeoutMs) {
-    tx_.active    = true;
-    tx_.sepRow    = row;
-    tx_.sepCol    = col;
-    tx_.timeoutMs = timeoutMs;
-    tx_.startTime = millis();
-    tx_.success   = false;
+    endTransaction(legacyTxn_);
+    legacyTxn_ = beginTransaction(Response::sep(row, col), timeoutMs);
+}
+
+bool Minitel::Response::matches(const Event& ev) const {
+    switch (kind) {
+    case SEP_CODE:
+        return ev.type == Event::SEP && (code == ANY || ev.code == code);
+    case POSITION:
+        return ev.type == Event::POSITION;
+    case PRO2:
+    case PRO3:
+        return ev.type == Event::ESCSEQ &&
+               ev.code == (kind == PRO2 ? 0x3A : 0x3B) &&
+               (code == ANY || ev.escData[0] == code) &&
+               (arg  == ANY || ev.escData[1] == arg);
+    }
+    return false;
+}
+
+void Minitel::finishTransaction(uint8_t i, TransactionState state, const Event& reply) {
+    Transaction& t = txns_[i];
+    t.reply = reply;
+    trace(Trace::TxnEnd, i | (state == TransactionState::Done ? 0x100 : 0));
+    if (!t.callback) {
+        t.state = state;
+        return;
+    }
+
+    // The slot is free again before the callback, which may chain the next request
+    t.state = TransactionState::Free;
+    t.callback(*this, (int8_t)i, state == TransactionState::Done, reply, t.ctx);
 }
 
-void Minitel::onSepForTransaction(uint8_t row, uint8_t col) {
-    if (!tx_.active) return;
-    if (tx_.sepRow != row || tx_.sepCol != col) return;
+bool Minitel::claimReply(const Event& ev) {
+    // Same reply expected twice (pipelined requests): oldest first
+    int8_t best = -1;
+    for (uint8_t i = 0; i < MINITEL_MAX_TRANSACTIONS; ++i) {
+        const Transaction& t = txns_[i];
+        if (t.state != TransactionState::Pending || !t.expect.matches(ev)) continue;
+        if (best < 0 || (int8_t)(t.order - txns_[best].order) < 0) best = (int8_t)i;
+    }
+    if (best < 0) return false;
 
-    tx_.active  = false;
-    tx_.success = true;
+    finishTransaction((uint8_t)best, TransactionState::Done, ev);
+    return true;
 }
 
 void Minitel::checkTransactionTimeout() {
-    if (!tx_.active) return;
-    if (tx_.timeoutMs == 0) return;
     unsigned long now = millis();
-    if ((uint16_t)(now - tx_.startTime) > tx_.timeoutMs) {
-        if (debug_) debug_->println(F("TX Timeout"));
-        tx_.active  = false;
-        tx_.success = false;
+    for (uint8_t i = 0; i < MINITEL_MAX_TRANSACTIONS; ++i) {
+        const Transaction& t = txns_[i];
+        if (t.state != TransactionState::Pending || t.timeoutMs == 0) continue;
+        if ((uint16_t)(now - t.startTime) <= t.timeoutMs) continue;
+
+        stats_.transactionTimeouts++;
+        Event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.type = Event::TIMEOUT;
+        finishTransaction(i, TransactionState::TimedOut, ev);
     }
 }
 
@@ -411,36 +1266,62 @@ void Minitel::checkTransactionTimeout() {
 // ----------------------------------------------------------------------------
 
 void Minitel::poll() {
-    if (!stream_) return;
+    poll(rxBudget_ ? rxBudget_ : 0xFFFF);
+}
+
+uint16_t Minitel::poll(uint16_t maxRxBytes) {
+    if (!stream_) return 0;
 
-    while (stream_->available()) {
+    // Whatever is left stays in the stream's RX buffer for the next call
+    uint16_t n = 0;
+    while (n < maxRxBytes && stream_->available()) {
         uint8_t c = stream_->read();
+        stats_.rxBytes++;
         parseByte(c);
+        ++n;
     }
 
     checkTransactionTimeout();
+    checkTerminalPower();
+
+    drainTx(txBudget_ ? txBudget_ : 0xFFFF);
+    return n;
+}
+
+void Minitel::setIdleHook(IdleHook fn, void* ctx) {
+    idleHook_ = fn;
+    idleCtx_  = ctx;
+}
+
+void Minitel::idle() {
+    if (idleHook_) idleHook_(idleCtx_);
+    else yield();
+}
+
+Minitel::WaitStatus Minitel::waitEventStep(Event& ev, unsigned long startMs,
+                                           uint16_t timeoutMs) {
+    poll();
+
+    if (readEvent(ev)) {
+        return WaitStatus::Ready;
+    }
+
+    if (timeoutMs > 0 && (uint16_t)(millis() - startMs) > timeoutMs) {
+        ev.type = Event::TIMEOUT;
+        return WaitStatus::Timeout;
+    }
+    return WaitStatus::Pending;
 }
 
 bool Minitel::waitEvent(Event& ev, uint16_t timeoutMs) {
     unsigned long start = millis();
 
     while (true) {
-        // 1. Process new bytes
-        poll();
-
-        // 2. Check for events
-        if (eventAvailable() && readEvent(ev)) {
-            return true;
+        WaitStatus st = waitEventStep(ev, start, timeoutMs);
+        if (st != WaitStatus::Pending) {
+            return st == WaitStatus::Ready;
         }
-
-        // 3. Check for timeout
-        if (timeoutMs > 0) {
-            if ((uint16_t)(millis() - start) > timeoutMs) {
-                ev.type = Event::TIMEOUT;
-                return false;
-            }
-        }
-        // No delay for maximum responsiveness at 1200 bauds
+        idle();
     }
 }
 
@@ -516,56 +1397,63 @@ bool Minitel::readLine(char* buf, size_t bufSize, bool echo,
 // ----------------------------------------------------------------------------
 // Screen / text helpers
 // ----------------------------------------------------------------------------
+uint16_t Minitel::repeatCost(uint16_t count) {
+    if (count == 0) return 0;
+
+    // First char, then REP chunks of up to 63; short tails go raw
+    uint16_t n    = count - 1;
+    uint16_t cost = 1 + 2 * (n / MAX_REP_COUNT);
+    n %= MAX_REP_COUNT;
+    return cost + ((n + 1 >= REP_THRESHOLD) ? 2 : n);
+}
+
+void Minitel::writeRepeated(uint8_t c, uint16_t count) {
+    if (count == 0) return;
+
+    writeRaw(c);
+
+    // REP repeats the last displayed char: REP can follow REP
+    uint16_t n = count - 1;
+    while (n >= MAX_REP_COUNT) {
+        writeRaw(C_REP);
+        writeRaw(0x40 + MAX_REP_COUNT);
+        n -= MAX_REP_COUNT;
+    }
+    if (n + 1 >= REP_THRESHOLD) {
+        writeRaw(C_REP);
+        writeRaw((uint8_t)(0x40 + n));
+    } else {
+        while (n--) writeRaw(c);
+    }
+}
+
 void Minitel::printOptimized(const char* s, size_t len) {
-    // TEMP: simple, safe version – no REP optimization
-    for (size_t i = 0; i < len; ++i) {
-        writeRaw((uint8_t)s[i]);
-    }
-}
-// void Minitel::printOptimized(const char* s, size_t len) {
-//     size_t i = 0;
-//     static const size_t MAX_REP_COUNT  = 95;
-//     static const size_t REP_THRESHOLD  = 4;
-
-//     while (i < len) {
-//         uint8_t current_char = (uint8_t)s[i];
-//         size_t j = i;
-//         while (j < len && (uint8_t)s[j] == current_char) {
-//             j++;
-//         }
-//         size_t run_length = j - i;
-
-//         if (run_length >= REP_THRESHOLD) {
-//             size_t reps_to_send = run_length;
-//             while (reps_to_send > 0) {
-//                 size_t current_reps = (reps_to_send > MAX_REP_COUNT)
-//                                       ? MAX_REP_COUNT : reps_to_send;
-
-//                 uint8_t count_byte = 0x1F + current_reps;
-//                 writeRaw(C_REP);
-//                 writeRaw(count_byte);
-//                 writeRaw(current_char);
-
-//                 reps_to_send -= current_reps;
-//             }
-//             i = j;
-//         } else {
-//             for (size_t k = 0; k < run_length; k++) {
-//                 writeRaw(current_char);
-//             }
-//             i = j;
-//         }
-//     }
-// }
+    size_t i = 0;
+
+    while (i < len) {
+        uint8_t c = (uint8_t)s[i] & 0x7F;
+        size_t  j = i + 1;
+
+        // Only displayable chars are repeated: controls (CR, LF, SO/SI...)
+        // end a run, so a run never crosses a line or charset switch.
+        if (c >= 0x20 && c < C_DEL) {
+            while (j < len && j - i < 0xFFFF && ((uint8_t)s[j] & 0x7F) == c) {
+                j++;
+            }
+            writeRepeated(c, (uint16_t)(j - i));
+        } else {
+            writeRaw(c);
+        }
+        i = j;
+    }
+}
 
 void Minitel::clearScreen() {
     writeRaw(C_FF);
-    currentSet_ = CharSet::G0_ALPHA;
 }
 
 void Minitel::home() {
     writeRaw(C_RS);
-    currentSet_ = CharSet::G0_ALPHA;
 }
 
 void Minitel::setCursor(uint8_t row, uint8_t col) {
@@ -574,15 +1462,21 @@ void Minitel::setCursor(uint8_t row, uint8_t col) {
     if (col < 1) col = 1;
     if (col > 40) col = 40;
 
+    // Already there with default attributes: US would change nothing
+    if (term_.cursorKnown && term_.row == row && term_.col == col &&
+        term_.attrsKnown && term_.charset == CharSet::G0_ALPHA &&
+        term_.fg == Color::White && term_.bg == Color::Black &&
+        !term_.flash && !term_.negative && term_.size == CharSize::Normal) {
+        return;
+    }
+
     uint8_t rowCode = 0x40 | (row & 0x1F);
     uint8_t colCode = 0x40 | (col & 0x3F);
 
+    // STUM: US restores attributes → we are back in G0
     writeRaw(C_US);
     writeRaw(rowCode);
     writeRaw(colCode);
-
-    // STUM: US restores attributes → we are back in G0
-    currentSet_ = CharSet::G0_ALPHA;
 }
 
 void Minitel::setCursorRow0(uint8_t col) {
@@ -595,18 +1489,15 @@ void Minitel::setCursorRow0(uint8_t col) {
     uint8_t rowCode = 0x40;                   // 4/0 => row 00
     uint8_t colCode = 0x40 | (col & 0x3F);    // X/Y, X in 4..7, Y = column
 
+    // US restores attributes: we're now in G0 on row 00
     writeRaw(C_US);
     writeRaw(rowCode);
     writeRaw(colCode);
-
-    // US restores attributes: we're now in G0 on row 00
-    currentSet_ = CharSet::G0_ALPHA;
 }
 
 void Minitel::putChar(char c) {
-    if (currentSet_ != CharSet::G0_ALPHA) {
+    if (term_.charset != CharSet::G0_ALPHA) {
         writeRaw(C_SI);
-        currentSet_ = CharSet::G0_ALPHA;
     }
     writeRaw((uint8_t)c);
 }
@@ -618,33 +1509,31 @@ void Minitel::printRow0(const char* s) {
     // Jump to row 00, column 1
     setCursorRow0(1);
 
-    // Print at most 40 characters, pad with spaces
-    uint8_t count = 0;
-    while (*s && count < 40) {
-        char c = *s++;
-        if (c == '\r' || c == '\n') break;  // stop on explicit newline
-        writeRaw(uint8_t(c) & 0x7F);        // G0 text
-        ++count;
+    // Print at most 40 characters (stop on explicit newline), pad with
+    // spaces. Trailing spaces join the padding so they share one REP.
+    uint8_t len = 0;
+    while (len < 40 && s[len] && s[len] != '\r' && s[len] != '\n') {
+        ++len;
     }
-    while (count < 40) {
-        writeRaw(' ');
-        ++count;
+    uint8_t count = len;
+    while (count > 0 && s[count - 1] == ' ') {
+        --count;
     }
+    printOptimized(s, count);         // G0 text
+    writeRepeated(' ', 40 - count);
 
     // Leave row 00 and restore previous position & attributes:
     // STUM: "The only way to leave row 0 is by sending a unit or
     // sub-unit separator or a LF."
     writeRaw(C_LF);
-    // After this, the Minitel restores previous row/col + attributes.
-    // currentSet_ stays as whatever Minitel chose; GFX will re-enter
-    // G1 when needed via beginSemiGraphics().
+    // After this, the Minitel restores previous row/col + attributes,
+    // and so does our state shadow.
 }
 
 
 void Minitel::print(const char* s) {
-    if (currentSet_ != CharSet::G0_ALPHA) {
+    if (term_.charset != CharSet::G0_ALPHA) {
         writeRaw(C_SI);
-        currentSet_ = CharSet::G0_ALPHA;
     }
     printOptimized(s, strlen(s));
 }
@@ -718,16 +1607,14 @@ void Minitel::print(unsigned long v, int base) {
 // ----------------------------------------------------------------------------
 
 void Minitel::beginSemiGraphics() {
-    if (currentSet_ != CharSet::G1_GRAPHIC) {
+    if (term_.charset != CharSet::G1_GRAPHIC) {
         writeRaw(C_SO);
-        currentSet_ = CharSet::G1_GRAPHIC;
     }
 }
 
 void Minitel::endSemiGraphics() {
-    if (currentSet_ != CharSet::G0_ALPHA) {
+    if (term_.charset != CharSet::G0_ALPHA) {
         writeRaw(C_SI);
-        currentSet_ = CharSet::G0_ALPHA;
     }
 }
 
@@ -737,9 +1624,8 @@ void Minitel::putSemiGraphic(uint8_t code) {
 }
 
 void Minitel::printSemiGraphics(const char* s) {
-    if (currentSet_ != CharSet::G1_GRAPHIC) {
+    if (term_.charset != CharSet::G1_GRAPHIC) {
         writeRaw(C_SO);
-        currentSet_ = CharSet::G1_GRAPHIC;
     }
     printOptimized(s, strlen(s));
 }
@@ -750,6 +1636,62 @@ void Minitel::putSemiGraphicAt(uint8_t row, uint8_t col, uint8_t code) {
     writeRaw(code & 0x7F);
 }
 
+// ----------------------------------------------------------------------------
+// DRCS
+// ----------------------------------------------------------------------------
+
+void Minitel::beginDrcsLoad() {
+    // G'0 set, 8x10 shapes
+    const uint8_t seq[] = { C_US, 0x23, 0x20, 0x20, 0x20, 0x42, 0x49 };
+    writeRaw(seq, sizeof(seq));
+}
+
+void Minitel::loadDrcsChar(uint8_t code, const uint8_t* rows, bool progmem) {
+    const uint8_t seq[] = { C_US, 0x23, code, 0x30 };
+    writeRaw(seq, sizeof(seq));
+
+    // 80 pixels, row after row, 6 bits per byte (+ 0x40): 14 bytes
+    uint16_t bits = 0;
+    uint8_t have = 0;
+    for (uint8_t i = 0; i < 10; ++i) {
+        bits = (bits << 8) | (progmem ? pgm_read_byte(rows + i) : rows[i]);
+        have += 8;
+        while (have >= 6) {
+            have -= 6;
+            writeRaw(0x40 | ((bits >> have) & 0x3F));
+        }
+    }
+    writeRaw(0x40 | ((bits << (6 - have)) & 0x3F));
+}
+
+void Minitel::selectDrcs(bool on) {
+    if (term_.drcs == on) {
+        return;
+    }
+    if (on) {
+        const uint8_t seq[] = { C_ESC, 0x28, 0x20, 0x42 };
+        writeRaw(seq, sizeof(seq));
+    } else {
+        const uint8_t seq[] = { C_ESC, 0x28, 0x42 };
+        writeRaw(seq, sizeof(seq));
+    }
+}
+
+void Minitel::setRollMode(bool on) {
+    if (term_.roll == on) {
+        return;
+    }
+    const uint8_t seq[] = { C_ESC, 0x3A, on ? PRO2_START : PRO2_STOP, MODE_ROLL };
+    // Armed before sending; if the table is full the reply is read as input
+    beginTransaction(Response::pro2(PRO2_MODE_STATUS),
+                     replyTimeout(ROLL_REPLY_TIMEOUT_MS, sizeof(seq)), ignoreReply);
+    writeRaw(seq, sizeof(seq));
+    term_.roll = on;
+}
+
+void Minitel::ignoreReply(Minitel&, int8_t, bool, const Event&, void*) {
+}
+
 // ----------------------------------------------------------------------------
 // PRO3: keyboard/screen switching
 // ----------------------------------------------------------------------------
@@ -773,7 +1715,11 @@ void Minitel::configureKeyboardToSocketOnly(bool useTransaction,
                                             uint16_t timeoutMs)
 {
     if (useTransaction) {
-        beginTransactionWaitSep(5, 4, timeoutMs);
+        // Each switch is acknowledged by ESC 3/B 6/3 <module> <status>;
+        // wait for the socket's
+        endTransaction(legacyTxn_);
+        legacyTxn_ = beginTransaction(Response::pro3(PRO3_SWITCH_STATUS, MOD_SOCKET_RX),
+                                      replyTimeout(timeoutMs, 3 * 5));
     }
 
     // keyboard -> modem OFF
@@ -786,21 +1732,54 @@ void Minitel::configureKeyboardToSocketOnly(bool useTransaction,
 
 
 
+// Attribute setters skip the escape when the shadow says it is already set
+
 void Minitel::setCharColor(Color c) {
+    if (term_.attrsKnown && term_.fg == c) return;
     writeRaw(0x1B);
     writeRaw(0x40 | (static_cast<uint8_t>(c) & 0x07)); // 4/0..4/7
 }
 
 void Minitel::setBgColor(Color c) {
+    if (term_.attrsKnown && term_.bg == c) return;
     writeRaw(0x1B);
     writeRaw(0x50 | (static_cast<uint8_t>(c) & 0x07)); // 5/0..5/7
 }
 
 void Minitel::setFlash(bool enable) {
+    if (term_.attrsKnown && term_.flash == enable) return;
     writeRaw(0x1B);
     writeRaw(enable ? 0x48 : 0x49); // 4/8 flash, 4/9 steady
 }
 
+void Minitel::setPolarity(bool negative) {
+    if (term_.attrsKnown && term_.negative == negative) return;
+    writeRaw(0x1B);
+    writeRaw(negative ? 0x5D : 0x5C); // 5/D inverse, 5/C normal
+}
+
+static void sendSize(Minitel& m, Minitel::CharSize size) {
+    if (m.termState().attrsKnown && m.termState().size == size) return;
+    m.writeRaw(0x1B);
+    m.writeRaw(0x4C + static_cast<uint8_t>(size)); // 4/C..4/F
+}
+
+void Minitel::setSizeNormal() {
+    sendSize(*this, CharSize::Normal);
+}
+
+void Minitel::setDoubleHeight(bool on) {
+    sendSize(*this, on ? CharSize::DoubleHeight : CharSize::Normal);
+}
+
+void Minitel::setDoubleWidth(bool on) {
+    sendSize(*this, on ? CharSize::DoubleWidth : CharSize::Normal);
+}
+
+void Minitel::setDoubleSize(bool on) {
+    sendSize(*this, on ? CharSize::DoubleSize : CharSize::Normal);
+}
+
 void Minitel::setLining(bool enable) {
     writeRaw(0x1B);
     writeRaw(enable ? 0x4A : 0x59); // 4/A start, 5/9 stop (field-level stop)
@@ -813,9 +1792,7 @@ void Minitel::setMaskReveal(bool reveal) {
 
 
 void Minitel::fillSpaces(uint8_t count) {
-    for (uint8_t i = 0; i < count; ++i) {
-        writeRaw(' ');
-    }
+    writeRepeated(' ', count);
 }
 
 void Minitel::putCharAt(uint8_t row, uint8_t col, char c) {
@@ -824,33 +1801,17 @@ void Minitel::putCharAt(uint8_t row, uint8_t col, char c) {
 }
 
 bool Minitel::requestCursorPosition(uint8_t& outRow, uint8_t& outCol, uint16_t timeoutMs) {
-    // Send ESC 6/1
-    writeRaw(C_ESC);
-    writeRaw(0x61);
+    // ESC 6/1, answered by US row col
+    static const uint8_t cmd[] = {C_ESC, 0x61};
+    int8_t h = sendRequest(cmd, sizeof(cmd), Response::position(), timeoutMs);
+    if (h < 0) return false;
 
     Event ev;
-    unsigned long start = millis();
-
-    while (millis() - start < timeoutMs) {
-        poll();
-        if (!eventAvailable()) continue;
-
-        if (readEvent(ev)) {
-            if (ev.type == Event::CONTROL && ev.code == C_US) {
-                // The next 2 CHAR events will be row & col
-                // Wait for row
-                if (!waitEvent(ev, 50)) return false;
-                if (ev.type != Event::CHAR) return false;
-                outRow = ev.code & 0x7F;
-
-                // Wait for col
-                if (!waitEvent(ev, 50)) return false;
-                if (ev.type != Event::CHAR) return false;
-                outCol = ev.code & 0x7F;
+    bool ok = waitTransaction(h) && transactionReply(h, ev);
+    endTransaction(h);
+    if (!ok) return false;
 
-                return true;
-            }
-        }
-    }
-    return false; // timeout
+    outRow = ev.row;
+    outCol = ev.col;
+    return true;
 }
\ No newline at end of file
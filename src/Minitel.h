@@ -2,6 +2,35 @@
 
 #include <Arduino.h>
 #include <Print.h>
+#include "MinitelEventQueue.h"
+
+/**
+ * Size of the TX queue in bytes (0 = write straight to the stream).
+ * writeRaw() writes straight through while the queue is empty and the
+ * stream has room; the rest is queued and drained from poll() (or
+ * flushTx()), so a large flush does not block the main loop at 1200
+ * bauds.
+ */
+#ifndef MINITEL_TX_QUEUE_SIZE
+#define MINITEL_TX_QUEUE_SIZE 256
+#endif
+
+/**
+ * Number of received events the FIFO holds (power of two, 4..128), at
+ * 4 bytes each. Events wait there between poll() and readEvent(), e.g.
+ * keys typed during a long blocking flush.
+ */
+#ifndef MINITEL_EVENT_QUEUE_SIZE
+#define MINITEL_EVENT_QUEUE_SIZE 32
+#endif
+
+/**
+ * Number of transactions (requests waiting for their reply) that can be
+ * in flight at once, ~20 bytes each.
+ */
+#ifndef MINITEL_MAX_TRANSACTIONS
+#define MINITEL_MAX_TRANSACTIONS 4
+#endif
 
 /**
  * @file Minitel.h
@@ -48,16 +77,20 @@ public:
             SEP,       ///< SEP 4/x, 5/x, etc. (two-byte sequence)
             ESCSEQ,    ///< ESC-based sequence (C1 or ESC 3B a b c)
             CONTROL,   ///< Other C0 controls
-            TIMEOUT    ///< Artificial event used by blocking helpers
+            TIMEOUT,   ///< Artificial event used by blocking helpers
+            POSITION   ///< US row col: reply to a cursor position request
         } type;
 
         uint8_t code;       ///< CHAR: character; SEP: second byte; ESCSEQ: opcode (e.g. 0x3B)
-        uint8_t row;        ///< SEP row (for type == SEP)
-        uint8_t col;        ///< SEP col (for type == SEP)
+        uint8_t row;        ///< SEP row (for type == SEP); POSITION: row
+        uint8_t col;        ///< SEP col (for type == SEP); POSITION: col
         uint8_t escLen;     ///< ESCSEQ: length of escData
         uint8_t escData[4]; ///< ESCSEQ: sequence payload (max 4 bytes)
     };
 
+    /** What the event FIFO does when full (default DropOld). */
+    typedef MinitelOverflowPolicy OverflowPolicy;
+
     /**
      * Internal state of the Minitel session (PT line).
      */
@@ -67,16 +100,166 @@ public:
         Open     ///< Session is open (Minitel ready to receive/send).
     };
 
+    enum class CharSet : uint8_t {
+        G0_ALPHA,   ///< Default (SI, Shift In)
+        G1_GRAPHIC  ///< Semi-graphics (SO, Shift Out)
+    };
+
+    // Couleurs 0..7 dans l'ordre du STUM
+    enum class Color : uint8_t {
+        Black   = 0,
+        Red     = 1,
+        Green   = 2,
+        Yellow  = 3,
+        Blue    = 4,
+        Magenta = 5,
+        Cyan    = 6,
+        White   = 7
+    };
+
+    // Character size, in the order of ESC 4/C..4/F
+    enum class CharSize : uint8_t {
+        Normal       = 0,
+        DoubleHeight = 1,
+        DoubleWidth  = 2,
+        DoubleSize   = 3
+    };
+
     /**
-     * Minitel transaction structure.
+     * Shadow of the terminal state, as far as the driver can tell.
+     *
+     * Every byte sent through writeRaw() is interpreted the way the
+     * terminal would, so this stays in sync whichever helper (or
+     * MinitelGfx) emitted it. US / RS / FF restore default attributes;
+     * row 00 access saves the state and the LF leaving it restores it.
+     */
+    struct TermState {
+        CharSet  charset     = CharSet::G0_ALPHA;
+        Color    fg          = Color::White;
+        Color    bg          = Color::Black;  ///< serial in G0 (needs a delimiter)
+        bool     flash       = false;
+        bool     negative    = false;         ///< inverse video (G0 only)
+        CharSize size        = CharSize::Normal;
+        bool     attrsKnown  = true;          ///< false: never skip attribute bytes
+        uint8_t  row         = 1;             ///< 0 = status row, 1..24
+        uint8_t  col         = 1;             ///< 1..40
+        bool     cursorKnown = false;
+        bool     drcs        = false;         ///< G0 is the DRCS set, see selectDrcs()
+        bool     roll        = false;         ///< roll mode, see setRollMode()
+        bool     echo        = false;         ///< local echo: keys move the cursor
+    };
+
+    /**
+     * Link counters, see stats() / dumpStats().
+     *
+     * TX bytes are classified as they are queued, by the same parser that
+     * keeps the terminal state shadow, so the categories add up to all
+     * that was sent whichever helper (or MinitelGfx) sent it.
+     */
+    struct Stats {
+        uint32_t txCursor     = 0;  ///< US row col, CSI, BS/HT/LF/VT/CR/RS
+        uint32_t txAttr       = 0;  ///< SI/SO and ESC 4/x, 5/x attributes
+        uint32_t txRep        = 0;  ///< REP + count
+        uint32_t txPayload    = 0;  ///< displayable chars (G0 text, G1 mosaics)
+        uint32_t txControl    = 0;  ///< FF, PRO1..3 sequences, other controls
+        uint32_t rxBytes      = 0;
+        uint32_t events       = 0;  ///< events queued
+        uint32_t flushes      = 0;  ///< MinitelGfx flushes with changed cells
+        uint32_t cellsChanged = 0;  ///< cells sent by MinitelGfx
+        uint16_t eventOverflows      = 0; ///< events lost: FIFO full
+        uint16_t parseErrors         = 0; ///< unsupported ESC sequences dropped
+        uint16_t transactionTimeouts = 0;
+
+        uint32_t txTotal() const {
+            return txCursor + txAttr + txRep + txPayload + txControl;
+        }
+    };
+
+    /**
+     * Reply a transaction waits for. Fields set to ANY match anything.
+     */
+    struct Response {
+        enum Kind : uint8_t {
+            SEP_CODE,  ///< SEP row/col, code = second byte (e.g. 0x54 for 5/4)
+            POSITION,  ///< US row col, answer to ESC 6/1
+            PRO2,      ///< ESC 3/A code arg (PRO2-style status replies)
+            PRO3       ///< ESC 3/B code arg x (e.g. 6/3: switching status)
+        };
+        static constexpr uint8_t ANY = 0xFF;
+
+        Kind    kind;
+        uint8_t code;
+        uint8_t arg;
+
+        static Response sep(uint8_t row, uint8_t col) {
+            return Response{SEP_CODE, (uint8_t)((row << 4) | (col & 0x0F)), ANY};
+        }
+        static Response position() { return Response{POSITION, ANY, ANY}; }
+        static Response pro2(uint8_t code, uint8_t arg = ANY) {
+            return Response{PRO2, code, arg};
+        }
+        static Response pro3(uint8_t code, uint8_t arg = ANY) {
+            return Response{PRO3, code, arg};
+        }
+
+        bool matches(const Event& ev) const;
+    };
+
+    enum class TransactionState : uint8_t {
+        Free,     ///< handle not in use
+        Pending,  ///< waiting for the reply
+        Done,     ///< reply received, see transactionReply()
+        TimedOut
+    };
+
+    /**
+     * Called from poll() when a transaction ends. `reply` is the matched
+     * event, or a TIMEOUT one. The handle is already free again.
+     */
+    typedef void (*TransactionCallback)(Minitel& m, int8_t handle, bool ok,
+                                        const Event& reply, void* ctx);
+
+    /**
+     * One slot of the transaction table.
      */
     struct Transaction {
-        bool active = false;          ///< true if transaction is running
-        uint8_t sepRow = 0;           ///< expected SEP row (4 or 5)
-        uint8_t sepCol = 0;           ///< expected SEP col (0 to 15)
-        uint16_t timeoutMs = 0;       ///< timeout in ms
+        TransactionState state = TransactionState::Free;
+        Response expect;
+        uint8_t order = 0;            ///< start order, oldest matches first
+        uint16_t timeoutMs = 0;       ///< timeout in ms (0 = none)
         unsigned long startTime = 0;  ///< millis() when transaction started
-        bool success = false;         ///< result of transaction
+        TransactionCallback callback = nullptr;
+        void* ctx = nullptr;
+        Event reply;
+    };
+
+    /**
+     * What beginTerminal() sets up, in that order, once the session is open.
+     */
+    struct TerminalConfig {
+        uint16_t sessionTimeoutMs = 2000;  ///< wait for SEP 5/4 after PT (0: don't)
+        bool keyboardToSocketOnly = true;  ///< PRO3 routing, see configureKeyboardToSocketOnly()
+        bool localEcho     = false;        ///< keyboard -> screen (PRO3); typed keys then lose the cursor shadow
+        bool lowercase     = false;        ///< lowercase keyboard (PRO2 start/stop 4/5)
+        bool cursorVisible = false;        ///< Con / Coff
+        bool clearScreen   = true;         ///< FF before the first screen
+        uint16_t ackTimeoutMs = 500;       ///< for each PRO3 / PRO2 acknowledgement, past the TX backlog
+        uint32_t baud = 1200;              ///< negotiateSpeed() to this first (needs setBaudSetter())
+
+        /** Draws the first screen, sent right behind the configuration. */
+        void (*firstScreen)(Minitel& m, void* ctx) = nullptr;
+        /** Everything acknowledged (ok), or the session / an ack timed out. */
+        void (*onReady)(Minitel& m, bool ok, void* ctx) = nullptr;
+        void* ctx = nullptr;
+    };
+
+    enum class BootState : uint8_t {
+        Idle,         ///< beginTerminal() not called
+        Opening,      ///< PT asserted, waiting for SEP 5/4
+        Negotiating,  ///< switching to TerminalConfig::baud
+        Configuring,  ///< configuration and first screen sent, acks pending
+        Ready,
+        Failed
     };
 
     // ---------------------------------------------------------------------
@@ -90,7 +273,7 @@ public:
      * @param stream  The Stream instance (e.g., &Serial1)
      * @param ptPin   Arduino pin driving the PT line (e.g., 2). Set to 255 to disable.
      * @param tpPin   Arduino pin reading the TP line (e.g., 3). Set to 255 to disable.
-     * @param debug   Optional Stream for debug output (e.g., &Serial).
+     * @param debug   Optional Stream for dumpStats() and diagnostics (e.g., &Serial).
      */
     void begin(Stream* stream, uint8_t ptPin = 255, uint8_t tpPin = 255, Stream* debug = nullptr);
 
@@ -132,6 +315,19 @@ public:
      */
     bool startSession(uint16_t timeoutMs = 0);
 
+    /**
+     * Non-blocking startup, driven by poll(): asserts PT, and as soon as
+     * SEP 5/4 arrives (at once without a PT pin or sessionTimeoutMs) sends
+     * the whole configuration, clears the screen and emits the first
+     * screen without waiting in between. The PRO3 acknowledgements and
+     * the REP STATUS FONCTIONNEMENT answering the keyboard case are
+     * collected while the screen goes out (never queued as input);
+     * onReady reports the outcome. Without a PT pin or sessionTimeoutMs
+     * the session is taken as open at once.
+     */
+    void beginTerminal(const TerminalConfig& cfg);
+    BootState bootState() const { return boot_; }
+
     /**
      * Releases the PT line to end a Minitel session.
      */
@@ -147,6 +343,49 @@ public:
      */
     SessionState sessionState() const { return sessionState_; }
 
+    // ---------------------------------------------------------------------
+    // Line speed (PROG)
+    // ---------------------------------------------------------------------
+
+    /**
+     * Reconfigures the local serial port, e.g.
+     * `[](uint32_t b, void*) { Serial1.begin(b, SERIAL_7E1); }`.
+     * Required by negotiateSpeed().
+     */
+    typedef void (*BaudSetter)(uint32_t baud, void* ctx);
+    void setBaudSetter(BaudSetter fn, void* ctx = nullptr);
+
+    /** End of a speed negotiation: `baud` is the speed now in use. */
+    typedef void (*SpeedCallback)(Minitel& m, bool ok, uint32_t baud, void* ctx);
+
+    /**
+     * Non-blocking switch to 300, 1200, 4800 or 9600 bauds, driven by
+     * poll(): asks the terminal its speed (ESC 3/9 7/4; a terminal
+     * without PROG, such as the Minitel 1, does not answer and nothing
+     * changes), sends PROG (ESC 3/A 6/B), switches the local port and
+     * asks again at the new speed. Without that answer both ends go back
+     * to the previous speed and `ok` is false.
+     *
+     * With a TP pin, beginTerminal() renegotiates after the terminal is
+     * switched off and on (it restarts at 1200 bauds). A negotiation
+     * running then is abandoned: `cb` gets ok false.
+     *
+     * @param timeoutMs  For each reply; 0 means the default 500 ms.
+     *
+     * @return false if not started: no stream or baud setter, unknown speed, or a
+     *         negotiation already running.
+     */
+    bool beginNegotiateSpeed(uint32_t baud, uint16_t timeoutMs = 500,
+                             SpeedCallback cb = nullptr, void* ctx = nullptr);
+
+    /**
+     * Same, blocking (polling, idle hook) until done.
+     * @return true if the link now runs at `baud`.
+     */
+    bool negotiateSpeed(uint32_t baud, uint16_t timeoutMs = 500);
+
+    bool speedNegotiating() const { return speedStep_ != SPEED_IDLE; }
+
     // ---------------------------------------------------------------------
     // Core I/O and Polling
     // ---------------------------------------------------------------------
@@ -154,15 +393,182 @@ public:
     /**
      * Polls the serial stream and processes incoming bytes into Events.
      * This must be called frequently in the main loop (or from blocking calls).
+     * Reads at most the RX budget (see setRxBudget()), then drains TX.
      */
     void poll();
 
     /**
-     * Sends raw bytes directly to the Minitel stream.
+     * Same as poll(), reading at most maxRxBytes input bytes: the rest
+     * waits in the stream's RX buffer, so a burst of input (pasted text,
+     * a status dump) costs a bounded time per call.
+     *
+     * @return number of input bytes processed.
+     */
+    uint16_t poll(uint16_t maxRxBytes);
+
+    /**
+     * Max input bytes parsed per poll() call (0 = all available).
+     */
+    void setRxBudget(uint16_t bytesPerPoll) { rxBudget_ = bytesPerPoll; }
+
+    /**
+     * Called on each turn of the blocking wait loops (waitEvent(),
+     * readChar(), readLine(), startSession(), requestCursorPosition()),
+     * e.g. to run other tasks or sleep until the next interrupt.
+     * nullptr (default) calls yield().
+     */
+    typedef void (*IdleHook)(void* ctx);
+    void setIdleHook(IdleHook fn, void* ctx = nullptr);
+
+    enum class WaitStatus : uint8_t {
+        Pending, ///< nothing yet, call again
+        Ready,   ///< event read
+        Timeout  ///< timeoutMs elapsed since startMs
+    };
+
+    /**
+     * One non-blocking turn of waitEvent(), for loops that have other
+     * work to interleave: polls once and reads an event if there is one.
+     *
+     * @param ev         The Event structure to populate.
+     * @param startMs    millis() when the wait began.
+     * @param timeoutMs  Max time to wait (0 for infinite wait).
+     */
+    WaitStatus waitEventStep(Event& ev, unsigned long startMs, uint16_t timeoutMs);
+
+    /**
+     * Sends raw bytes to the Minitel stream (through the TX queue).
+     * The terminal state shadow follows whatever is sent.
      */
     void writeRaw(const uint8_t* data, size_t len);
     void writeRaw(uint8_t c);
 
+    /**
+     * Same as writeRaw() for bytes in flash (PROGMEM), read one at a
+     * time, e.g. a page from extras/host/pagec. Nothing is copied to
+     * SRAM beyond what the TX queue holds.
+     */
+    void writeProgmem(const uint8_t* data, size_t len);
+
+    /**
+     * Sends `c` count times in the current charset, using REP
+     * (1/2, 4/0 + n, n <= 63) whenever it is shorter.
+     */
+    void writeRepeated(uint8_t c, uint16_t count);
+
+    /**
+     * Bytes writeRepeated() needs for `count` copies of one char.
+     */
+    static uint16_t repeatCost(uint16_t count);
+
+    /**
+     * Current terminal state shadow (charset, attributes, cursor).
+     */
+    const TermState& termState() const { return term_; }
+
+    /**
+     * Forget cursor and attributes, e.g. after writing to the stream
+     * behind the driver's back or when local echo may have moved the
+     * cursor. The next emitters then re-send what they need.
+     */
+    void invalidateTermState();
+
+    // ---------------------------------------------------------------------
+    // TX queue
+    // ---------------------------------------------------------------------
+
+    /**
+     * Moves queued bytes to the stream, never more than maxBytes and,
+     * unless disabled, never more than stream->availableForWrite().
+     *
+     * @return number of bytes handed to the stream.
+     */
+    uint16_t drainTx(uint16_t maxBytes = 0xFFFF);
+
+    /**
+     * Blocks until the TX queue is empty.
+     */
+    void flushTx();
+
+    /**
+     * Max bytes drained per poll() call (0 = no limit besides the
+     * stream's own TX buffer room).
+     */
+    void setTxBudget(uint16_t bytesPerPoll) { txBudget_ = bytesPerPoll; }
+
+    /**
+     * Use stream->availableForWrite() to never block while draining.
+     * begin() turns this on if the idle stream reports some room, off
+     * otherwise (streams that do not implement it always read 0).
+     */
+    void setTxUseAvailableForWrite(bool enable) { txCheckRoom_ = enable; }
+
+    /**
+     * Line speed (bauds), used for drain time estimates.
+     */
+    void setBaudRate(uint32_t baud) { baud_ = baud ? baud : 1200; }
+    uint32_t baudRate() const { return baud_; }
+
+    /** Bytes waiting in the TX queue. */
+    uint16_t txQueued() const;
+
+    /** Free room in the TX queue. */
+    uint16_t txFree() const;
+
+    /**
+     * Estimated time for the queued bytes to go out on the wire
+     * (10 bits per char for 7E1).
+     */
+    uint32_t txDrainTimeMs() const;
+
+    // ---------------------------------------------------------------------
+    // Statistics
+    // ---------------------------------------------------------------------
+
+    /**
+     * Counters since begin() or the last resetStats(). Cheap enough to
+     * stay on in timing-sensitive builds, unlike printing every byte.
+     */
+    const Stats& stats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+    /**
+     * Prints the counters on a few lines, to `out` or, by default, to
+     * the debug stream given to begin() / setDebug().
+     */
+    void dumpStats(Print* out = nullptr) const;
+
+    /**
+     * Called by MinitelGfx: `cells` cells sent, by a flush or not.
+     */
+    void countCells(uint16_t cells, bool flush);
+
+    /**
+     * Points of the driver's work for a profiler's timeline, e.g. a
+     * MinitelRecorder. `arg` depends on the point.
+     */
+    enum class Trace : uint8_t {
+        FlushBegin, ///< MinitelGfx::flush() starts, arg = txQueued()
+        FlushEnd,   ///< arg = bytes the flush queued
+        TxnBegin,   ///< transaction armed, arg = handle
+        TxnEnd      ///< arg = handle, | 0x100 if the reply came
+    };
+
+    /**
+     * Called at each Trace point (nullptr, the default: nothing).
+     * Runs inside the driver: keep it to a few microseconds.
+     */
+    typedef void (*TraceHook)(Trace what, uint16_t arg, void* ctx);
+    void setTraceHook(TraceHook fn, void* ctx = nullptr) {
+        traceHook_ = fn;
+        traceCtx_  = ctx;
+    }
+
+    /** Called by MinitelGfx. */
+    void trace(Trace what, uint16_t arg = 0) {
+        if (traceHook_) traceHook_(what, arg, traceCtx_);
+    }
+
     // ---------------------------------------------------------------------
     // Event Queue Access
     // ---------------------------------------------------------------------
@@ -173,16 +579,49 @@ public:
     bool eventAvailable() const;
 
     /**
-     * Reads the next event from the FIFO.
+     * Reads the next event from the FIFO. A coalesced event is returned
+     * once per occurrence.
      *
      * @param ev  The Event structure to populate.
      * @return true if an event was read, false otherwise.
      */
     bool readEvent(Event& ev);
 
+    /**
+     * Zero-copy access to the oldest event (nullptr if none), in its
+     * packed form, until consumeEvent(). `repeat()` tells how many times
+     * it came in a row; consumeEvent() drops all of them.
+     */
+    const MinitelPackedEvent* peekEvent() const { return events_.peek(); }
+    void consumeEvent() { events_.consume(); }
+
+    /**
+     * Expands a packed event (see peekEvent()).
+     */
+    static Event unpackEvent(const MinitelPackedEvent& p);
+
+    /**
+     * Overflow handling of the event FIFO. pushEventFromISR() never drops
+     * the oldest event (its DropOld is DropNew), which would race the
+     * consumer; events from poll() follow the policy as set.
+     */
+    void setEventOverflowPolicy(OverflowPolicy policy) { events_.setPolicy(policy); }
+
+    /**
+     * Queues an event from an interrupt handler (e.g. a second UART with
+     * a keyboard or barcode reader), while the main loop reads events.
+     * Such events are never taken as transaction replies (claiming one
+     * runs callbacks), and the events / eventOverflows counters they
+     * bump may read torn if the main loop reads them meanwhile.
+     *
+     * @return false if an event was lost (queue full).
+     */
+    bool pushEventFromISR(const Event& ev);
+
     /**
      * Blocks until an Event is available or timeout is reached.
-     * Optimized for 1200 bauds: no delay(1) calls.
+     * Optimized for 1200 bauds: no delay(1) calls; the idle hook runs
+     * between polls.
      *
      * @param ev  The Event structure to populate.
      * @param timeoutMs  Max time to wait (0 for infinite wait).
@@ -255,6 +694,38 @@ void printRow0(const char* s);
     void beginSemiGraphics();
     void endSemiGraphics();
 
+    // ---------------------------------------------------------------------
+    // DRCS: redefinable characters (not on every terminal)
+    // ---------------------------------------------------------------------
+
+    /**
+     * Start loading shapes into the DRCS G0 set (US 2/3 header).
+     * Loading ends with the next cursor positioning (setCursor()).
+     */
+    void beginDrcsLoad();
+
+    /**
+     * Shape of DRCS code 0x21..0x7E, after beginDrcsLoad().
+     *
+     * @param rows     10 rows of 8 pixels, MSB = leftmost.
+     * @param progmem  If true, rows are read from flash.
+     */
+    void loadDrcsChar(uint8_t code, const uint8_t* rows, bool progmem = false);
+
+    /**
+     * Designate the DRCS set as G0 (ESC 2/8 2/0 4/2), or the standard
+     * one back (ESC 2/8 4/2). Sends nothing if already so.
+     */
+    void selectDrcs(bool on);
+
+    /**
+     * Roll mode (PRO2 start / stop 4/3): an LF on row 24 or a VT on
+     * row 1 scrolls the screen, and so does writing past the end of
+     * row 24. Sends nothing if already so; otherwise the terminal's REP
+     * STATUS FONCTIONNEMENT reply is claimed, not queued as input.
+     */
+    void setRollMode(bool on);
+
     // ---------------------------------------------------------------------
     // PRO3: keyboard/screen switching
     // ---------------------------------------------------------------------
@@ -268,42 +739,66 @@ void printRow0(const char* s);
     // ---------------------------------------------------------------------
 
     /**
-     * Starts a transaction waiting for a specific SEP sequence (e.g., 5/4).
-     * Non-blocking: result is updated internally when SEP arrives or timeout.
+     * Starts a transaction waiting for `expect`. Non-blocking: the first
+     * matching input (oldest transaction first when several expect the
+     * same reply) ends it, and is not queued as an event.
+     *
+     * @param cb  Optional: called on reply or timeout, then the handle is
+     *            released. Without it, poll transactionState() and call
+     *            endTransaction() once done.
+     * @return handle, or -1 if MINITEL_MAX_TRANSACTIONS are in flight.
      */
-    void beginTransactionWaitSep(uint8_t sepRow, uint8_t sepCol, uint16_t timeoutMs);
+    int8_t beginTransaction(const Response& expect, uint16_t timeoutMs,
+                            TransactionCallback cb = nullptr, void* ctx = nullptr);
 
     /**
-     * Returns true if the last transaction was successful.
+     * beginTransaction(), then sends `cmd`. Several requests may be in
+     * flight, so independent queries cost one round trip together. The
+     * timeout counts from when `cmd` should be out: the time to drain
+     * the TX queue ahead of it is added.
      */
-    bool transactionSuccess() const { return tx_.success; }
+    int8_t sendRequest(const uint8_t* cmd, uint8_t len, const Response& expect,
+                       uint16_t timeoutMs, TransactionCallback cb = nullptr,
+                       void* ctx = nullptr);
 
-        enum class CharSet : uint8_t {
-        G0_ALPHA,   ///< Default (SI, Shift In)
-        G1_GRAPHIC  ///< Semi-graphics (SO, Shift Out)
-    };
-    CharSet currentSet_ = CharSet::G0_ALPHA;
+    TransactionState transactionState(int8_t handle) const;
 
+    /** The matched reply, once Done. */
+    bool transactionReply(int8_t handle, Event& reply) const;
 
+    /** Releases the handle (cancels it if still pending). */
+    void endTransaction(int8_t handle);
 
-    // Couleurs 0..7 dans l'ordre du STUM
-enum class Color : uint8_t {
-    Black   = 0,
-    Red     = 1,
-    Green   = 2,
-    Yellow  = 3,
-    Blue    = 4,
-    Magenta = 5,
-    Cyan    = 6,
-    White   = 7
-};
+    /**
+     * Blocks (polling, idle hook) until the transaction is over.
+     * @return true if its reply came.
+     */
+    bool waitTransaction(int8_t handle);
+
+    uint8_t transactionsPending() const;
+
+    /**
+     * Starts a transaction waiting for a specific SEP sequence (e.g., 5/4).
+     * Non-blocking: result is updated internally when SEP arrives or timeout.
+     * Replaces the previous one started this way.
+     */
+    void beginTransactionWaitSep(uint8_t sepRow, uint8_t sepCol, uint16_t timeoutMs);
+
+    /**
+     * Returns true if the last transaction started by
+     * beginTransactionWaitSep() (or configureKeyboardToSocketOnly()) got
+     * its reply.
+     */
+    bool transactionSuccess() const {
+        return transactionState(legacyTxn_) == TransactionState::Done;
+    }
 
 void setCharColor(Color c);    // ESC 4/x
 void setBgColor(Color c);      // ESC 5/x
 
 void setFlash(bool enable);    // ESC 4/8 ou 4/9
 void setLining(bool enable);   // ESC 4/A (start) ou 5/9 (stop field-level)
-void setPolarity(bool negative); // ESC 5/C / 5/D (attention : pas en G1)
+void setPolarity(bool negative); // ESC 5/D / 5/C (attention : pas en G1)
 void setSizeNormal();          // ESC 4/C
 void setDoubleHeight(bool on); // ESC 4/D + gestion interne
 void setDoubleWidth(bool on);  // ESC 4/E + gestion interne
@@ -313,7 +808,8 @@ void setDoubleSize(bool on);   // ESC 4/F + gestion interne
 void setMaskReveal(bool reveal); // false => conceal (5/8), true => reveal (5/F)
 
 
-// Screen geometry (default Minitel 1)
+// Screen geometry: fixed at the Minitel 1's 40 x 24 (setCursor() clamps
+// to it too), whatever the size of the MinitelGfxT canvases
 uint8_t rows() const { return 24; }
 uint8_t cols() const { return 40; }
 
@@ -340,10 +836,7 @@ private:
 
 
     // --- Event FIFO ---
-    static const uint8_t EVENTBUF_SIZE = 16;
-    Event   eventBuf_[EVENTBUF_SIZE];
-    uint8_t eventHead_ = 0;     ///< index of next free slot.
-    uint8_t eventTail_ = 0;     ///< index of next unread event.
+    MinitelEventQueue<MINITEL_EVENT_QUEUE_SIZE> events_;
 
     // --- SEP and ESC parsing state ---
     bool waitingSepSecond_ = false;
@@ -351,14 +844,80 @@ private:
     enum EscState : uint8_t {
         ESC_IDLE,
         ESC_GOT_ESC,
-        ESC_3B
+        ESC_PRO
     };
     EscState escState_   = ESC_IDLE;
     uint8_t  escTmp_[4]  = {0};
     uint8_t  escTmpLen_  = 0;
-
-    // --- Current transaction ---
-    Transaction tx_;
+    uint8_t  escCode_    = 0;   ///< ESC_PRO: 3/9..3/B
+
+    // --- US row col reply ---
+    uint8_t usState_ = 0;       ///< 1: row expected, 2: col expected
+    uint8_t usRow_   = 0;
+
+    // --- Transactions ---
+    Transaction txns_[MINITEL_MAX_TRANSACTIONS];
+    uint8_t txnOrder_  = 0;
+    int8_t  legacyTxn_ = -1;    ///< beginTransactionWaitSep()
+
+    // --- beginTerminal() ---
+    BootState      boot_ = BootState::Idle;
+    TerminalConfig bootCfg_;
+    uint8_t        bootAcks_   = 0;     ///< PRO3 acknowledgements still expected
+    bool           bootStatus_ = false; ///< lowercase mode reply still expected
+
+    // --- Speed negotiation ---
+    enum SpeedStep : uint8_t {
+        SPEED_IDLE,
+        SPEED_QUERY,     ///< asking the current speed
+        SPEED_VERIFY,    ///< switched, asking again
+        SPEED_FALLBACK   ///< back to the previous speed, asking again
+    };
+    SpeedStep     speedStep_      = SPEED_IDLE;
+    uint32_t      speedTarget_    = 0;
+    uint32_t      speedPrev_      = 0;
+    uint16_t      speedTimeoutMs_ = 0;
+    SpeedCallback speedCb_        = nullptr;
+    void*         speedCtx_       = nullptr;
+    BaudSetter    baudSetter_     = nullptr;
+    void*         baudSetterCtx_  = nullptr;
+    bool          terminalOn_     = false;   ///< TP, as last seen by poll()
+
+    // --- TX queue ---
+#if MINITEL_TX_QUEUE_SIZE > 0
+    uint8_t  txBuf_[MINITEL_TX_QUEUE_SIZE];
+    uint16_t txHead_ = 0;       ///< index of next free slot.
+    uint16_t txTail_ = 0;       ///< index of next byte to send.
+    uint16_t txCount_ = 0;
+#endif
+    uint16_t txBudget_    = 0;
+    uint16_t rxBudget_    = 0;
+    IdleHook idleHook_    = nullptr;
+    void*    idleCtx_     = nullptr;
+    bool     txCheckRoom_ = true;
+    uint32_t baud_        = 1200;
+
+    Stats stats_;
+    TraceHook traceHook_ = nullptr;
+    void*     traceCtx_  = nullptr;
+
+    // --- Terminal state shadow (TX side) ---
+    TermState term_;
+    TermState row0Saved_;       ///< state before entering row 00
+
+    enum TxSeq : uint8_t {
+        TXS_NONE,
+        TXS_ESC,
+        TXS_CSI,
+        TXS_US_ROW,
+        TXS_US_COL,
+        TXS_REP,
+        TXS_SKIP,
+        TXS_DESIGNATE,
+        TXS_DRCS
+    };
+    TxSeq   txSeq_  = TXS_NONE;
+    uint8_t txArg_  = 0;        ///< US row byte / bytes left in TXS_SKIP / designated set
 
     // ---------------------------------------------------------------------
     // Internal helpers
@@ -366,12 +925,37 @@ private:
 
     void setPT(bool active);
     void pushEvent(const Event& ev);
+    bool queueEvent(const Event& ev, OverflowPolicy policy);
+    static MinitelPackedEvent packEvent(const Event& ev);
     void parseByte(uint8_t c);
     bool handleLineEditingControl(uint8_t c);
     void handleSep(uint8_t secondByte);
     void handleEscByte(uint8_t c);
-    void onSepForTransaction(uint8_t row, uint8_t col);
+    bool claimReply(const Event& ev);
+    void finishTransaction(uint8_t i, TransactionState state, const Event& reply);
     void checkTransactionTimeout();
+    uint16_t replyTimeout(uint16_t timeoutMs, uint16_t sending) const;
+    void idle();
+
+    void bootConfigure();
+    void bootArmAck();
+    void bootFinish(bool ok);
+    static void bootOnSession(Minitel& m, int8_t h, bool ok, const Event& reply, void* ctx);
+    static void bootOnAck(Minitel& m, int8_t h, bool ok, const Event& reply, void* ctx);
+    static void bootOnStatus(Minitel& m, int8_t h, bool ok, const Event& reply, void* ctx);
+    static void ignoreReply(Minitel& m, int8_t h, bool ok, const Event& reply, void* ctx);
+    void bootNegotiate();
+    static void bootOnSpeed(Minitel& m, bool ok, uint32_t baud, void* ctx);
+    void checkTerminalPower();
+
+    void speedQuery();
+    void speedSwitch(uint32_t baud);
+    void speedFinish(bool ok);
+    static void speedOnReply(Minitel& m, int8_t h, bool ok, const Event& reply, void* ctx);
 
     void printOptimized(const char* s, size_t len);
+
+    void trackTx(uint8_t b);
+    void resetAttributes();
+    void advanceCursor(uint8_t count);
 };
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <Arduino.h>
+
+// One received event in 4 bytes, as queued by Minitel (which unpacks it
+// into a Minitel::Event for readEvent()).
+//
+//   type     bits 0-4: Minitel::Event::Type; bit 7: PACKED_SEQ
+//   data[0]  CHAR / CONTROL: the char; SEP: second byte; ESC: opcode
+//   data[1]  how many times in a row it came (see Coalesce), >= 1
+//
+// With PACKED_SEQ, bits 5-6 of type give a payload length n and data[0..n-1]
+// hold the payload: ESC 3/A a b (n = 2), ESC 3/B a b c (n = 3), US row col
+// (POSITION, n = 2). Those are never coalesced.
+struct MinitelPackedEvent
+{
+    static const uint8_t PACKED_SEQ = 0x80;
+    static const uint8_t TYPE_MASK  = 0x1F;
+
+    uint8_t type;
+    uint8_t data[3];
+
+    bool isSeq() const { return type & PACKED_SEQ; }
+    uint8_t seqLen() const { return (type >> 5) & 0x03; }
+    uint8_t repeat() const { return isSeq() ? 1 : data[1]; }
+};
+
+// What push() does when the queue is full
+enum class MinitelOverflowPolicy : uint8_t
+{
+    DropNew,  // keep what is queued, lose the new event
+    DropOld,  // lose the oldest event (not safe with an ISR producer)
+    Coalesce  // same as the newest event: count it there; else DropNew
+};
+
+// Fixed-size FIFO of packed events, filled by one producer and read by
+// one consumer without locks: the producer only writes head_ and the
+// consumer only writes tail_, so with DropNew or Coalesce a serial RX
+// interrupt may push while the main loop peeks and consumes. DropOld
+// makes the producer advance tail_ too; use it when both sides run in
+// the same context (e.g. everything from poll()), and have an interrupt
+// push with push(ev, policy) and a policy other than DropOld.
+//
+// N is a power of two up to 128: the indices run freely over 0..255, so
+// all N slots are usable and a full queue is head_ - tail_ == N.
+template <uint8_t N>
+class MinitelEventQueue
+{
+    static_assert(N >= 4 && N <= 128 && (N & (N - 1)) == 0,
+                  "MinitelEventQueue size must be a power of two in 4..128");
+
+public:
+    static constexpr uint8_t capacity() { return N; }
+
+    void setPolicy(MinitelOverflowPolicy policy) { policy_ = policy; }
+    MinitelOverflowPolicy policy() const { return policy_; }
+
+    uint8_t size() const { return (uint8_t)(head_ - tail_); }
+    bool empty() const { return head_ == tail_; }
+
+    // Producer. False if an event was lost (the new one or, with
+    // DropOld, the oldest). A coalesced event is not lost.
+    bool push(const MinitelPackedEvent &ev) { return push(ev, policy_); }
+
+    // Same, with `policy` instead of policy()
+    bool push(const MinitelPackedEvent &ev, MinitelOverflowPolicy policy)
+    {
+        uint8_t head = head_;
+        if ((uint8_t)(head - tail_) < N)
+        {
+            store(head, ev);
+            return true;
+        }
+
+        switch (policy)
+        {
+        case MinitelOverflowPolicy::DropOld:
+            tail_ = tail_ + 1;
+            store(head, ev);
+            return false;
+
+        case MinitelOverflowPolicy::Coalesce:
+        {
+            // The newest slot is never the one being read: the queue is
+            // full and holds at least 4 events
+            MinitelPackedEvent &last = buf_[(uint8_t)(head - 1) & (N - 1)];
+            if (!ev.isSeq() &&
+                last.type == ev.type && last.data[0] == ev.data[0] &&
+                (uint16_t)last.data[1] + ev.data[1] <= 0xFF)
+            {
+                last.data[1] += ev.data[1];
+                return true;
+            }
+            return false;
+        }
+
+        default:
+            return false;
+        }
+    }
+
+    // Consumer: the oldest event, in place (nullptr when empty). It stays
+    // valid until consume(), except under DropOld overflows.
+    const MinitelPackedEvent *peek() const
+    {
+        if (empty())
+            return nullptr;
+        return &buf_[tail_ & (N - 1)];
+    }
+
+    // Consumer: drop the oldest event
+    void consume()
+    {
+        if (!empty())
+            tail_ = tail_ + 1;
+    }
+
+    // Consumer: take one occurrence of a repeated event, consuming it
+    // with its last one. False when empty.
+    bool consumeOne(MinitelPackedEvent &ev)
+    {
+        if (empty())
+            return false;
+        MinitelPackedEvent &slot = buf_[tail_ & (N - 1)];
+        ev = slot;
+        if (slot.repeat() > 1)
+        {
+            ev.data[1] = 1;
+            --slot.data[1];
+        }
+        else
+        {
+            tail_ = tail_ + 1;
+        }
+        return true;
+    }
+
+    void clear() { tail_ = head_; }
+
+private:
+    MinitelPackedEvent buf_[N];
+    volatile uint8_t head_ = 0; // slots written, mod 256
+    volatile uint8_t tail_ = 0; // slots read, mod 256
+    MinitelOverflowPolicy policy_ = MinitelOverflowPolicy::DropOld;
+
+    void store(uint8_t head, const MinitelPackedEvent &ev)
+    {
+        buf_[head & (N - 1)] = ev;
+        // The slot must be complete before the consumer can see it
+        __asm__ __volatile__("" ::: "memory");
+        head_ = head + 1;
+    }
+};
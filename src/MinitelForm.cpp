@@ -0,0 +1,202 @@
+#include "MinitelForm.h"
+
+#include <string.h>
+
+MinitelForm::MinitelForm(Minitel &dev, Echo echo)
+    : dev_(dev), echo_(echo)
+{
+}
+
+// ---------------------- Fields -------------------------
+
+int8_t MinitelForm::addField(uint8_t row, uint8_t col, uint8_t width,
+                             char *buf, uint8_t size)
+{
+    if (count_ >= MINITEL_FORM_MAX_FIELDS || !buf || size == 0 || width == 0)
+        return -1;
+
+    Field &f = fields_[count_];
+    f.buf = buf;
+    f.row = row;
+    f.col = col;
+    f.width = width;
+    f.max = (size - 1 < width) ? size - 1 : width;
+    buf[f.max] = '\0';
+    f.len = strlen(buf);
+    return count_++;
+}
+
+void MinitelForm::begin(uint8_t field)
+{
+    for (uint8_t i = 0; i < count_; ++i)
+        drawField(i);
+    active_ = count_ > 0;
+    focus_ = (field < count_) ? field : 0;
+    placeCursor();
+}
+
+void MinitelForm::setFocus(uint8_t field)
+{
+    if (field >= count_)
+        return;
+    focus_ = field;
+    placeCursor();
+}
+
+void MinitelForm::clearField(uint8_t field)
+{
+    if (field >= count_)
+        return;
+    Field &f = fields_[field];
+    if (f.len > 0)
+    {
+        dev_.setCursor(f.row, f.col);
+        dev_.writeRepeated(fill_, f.len);
+    }
+    f.len = 0;
+    f.buf[0] = '\0';
+}
+
+void MinitelForm::drawField(uint8_t field)
+{
+    if (field >= count_)
+        return;
+    const Field &f = fields_[field];
+    dev_.setCursor(f.row, f.col);
+    dev_.print(f.buf);
+    dev_.writeRepeated(fill_, f.width - f.len);
+}
+
+// ---------------------- Input -------------------------
+
+MinitelForm::Status MinitelForm::update()
+{
+    if (!active_)
+        return Status::Editing;
+
+    while (const MinitelPackedEvent *p = dev_.peekEvent())
+    {
+        Minitel::Event ev = Minitel::unpackEvent(*p);
+        Action a = HANDLED;
+        // A coalesced key counts once per press
+        for (uint8_t n = p->repeat(); n > 0 && a == HANDLED; --n)
+            a = handle(ev);
+
+        if (a == NOT_MINE)
+        {
+            placeCursor();
+            return Status::Key;
+        }
+        dev_.consumeEvent();
+        if (a == SENT)
+        {
+            active_ = false;
+            return Status::Sent;
+        }
+    }
+    placeCursor();
+    return Status::Editing;
+}
+
+MinitelForm::Action MinitelForm::handle(const Minitel::Event &ev)
+{
+    if (ev.type == Minitel::Event::CHAR)
+    {
+        if (ev.code >= 0x20 && ev.code <= 0x7E)
+        {
+            insert(ev.code);
+            return HANDLED;
+        }
+        if (ev.code == 0x08) // BS
+        {
+            erase();
+            return HANDLED;
+        }
+        if (ev.code == 0x0D || ev.code == 0x0A) // CR / LF
+        {
+            if (focus_ + 1 >= count_)
+                return SENT;
+            focus_++;
+            return HANDLED;
+        }
+        return NOT_MINE;
+    }
+
+    if (ev.type != Minitel::Event::SEP)
+        return NOT_MINE;
+
+    switch (ev.code)
+    {
+    case Minitel::SEP_SEND:
+        return SENT;
+    case Minitel::SEP_ERASE:
+        erase();
+        return HANDLED;
+    case Minitel::SEP_CANCEL:
+        clearField(focus_);
+        return HANDLED;
+    case Minitel::SEP_NEXT:
+        focus_ = (focus_ + 1 < count_) ? focus_ + 1 : 0;
+        return HANDLED;
+    case Minitel::SEP_PREVIOUS:
+        focus_ = (focus_ > 0) ? focus_ - 1 : count_ - 1;
+        return HANDLED;
+    default:
+        return NOT_MINE;
+    }
+}
+
+void MinitelForm::insert(uint8_t c)
+{
+    Field &f = fields_[focus_];
+    if (f.len >= f.max)
+    {
+        // The terminal has echoed it at the cursor already: put back
+        // what was there
+        if (echo_ == Echo::Terminal)
+        {
+            uint8_t at = (f.len < f.width) ? f.len : f.width - 1;
+            dev_.invalidateTermState();
+            dev_.setCursor(f.row, f.col + at);
+            dev_.putChar(at < f.len ? f.buf[at] : fill_);
+        }
+        return;
+    }
+
+    if (echo_ == Echo::Driver)
+    {
+        placeCursor();
+        dev_.putChar(c);
+    }
+    else
+    {
+        // The cursor moved on the terminal, behind the driver's back
+        dev_.invalidateTermState();
+    }
+    f.buf[f.len++] = c;
+    f.buf[f.len] = '\0';
+}
+
+void MinitelForm::erase()
+{
+    Field &f = fields_[focus_];
+    if (f.len == 0)
+        return;
+    f.buf[--f.len] = '\0';
+    dev_.setCursor(f.row, f.col + f.len);
+    dev_.putChar(fill_);
+}
+
+// Editing position: after the last char (on it when the field is full)
+void MinitelForm::placeCursor()
+{
+    if (!active_ || count_ == 0)
+        return;
+    const Field &f = fields_[focus_];
+    uint8_t col = f.col + ((f.len < f.width) ? f.len : f.width - 1);
+
+    const Minitel::TermState &t = dev_.termState();
+    if (t.cursorKnown && t.row == f.row && t.col == col)
+        return;
+    dev_.setCursor(f.row, col);
+}
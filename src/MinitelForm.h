@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Minitel.h"
+
+// Most fields one form can hold
+#ifndef MINITEL_FORM_MAX_FIELDS
+#define MINITEL_FORM_MAX_FIELDS 8
+#endif
+
+// Non-blocking input fields, fed from the event queue: unlike
+// readLine(), nothing waits for the user, so animations and TX draining
+// go on while they type. A single line editor is a form of one field.
+//
+//   char name[16], city[16];
+//   MinitelForm form(minitel);
+//   form.addField(5, 10, 15, name, sizeof(name));
+//   form.addField(7, 10, 15, city, sizeof(city));
+//   form.begin();                    // draws the fields, cursor on the first
+//
+//   void loop() {
+//     minitel.poll();
+//     switch (form.update()) {       // handles what the user typed
+//     case MinitelForm::Status::Sent: submit(name, city); break;
+//     case MinitelForm::Status::Key:  handleKey();        break; // e.g. SOMMAIRE
+//     default: break;
+//     }
+//     animate();
+//     gfx.flush();
+//   }
+//
+// Keys: characters fill the field, CORRECTION (or BS) erases the last
+// one, ANNULATION clears the field, SUITE / RETOUR move to the next /
+// previous field (CR too, to the next), ENVOI sends the form. Anything
+// else stops update() with Status::Key, left at the head of the queue
+// for the sketch to readEvent().
+//
+// update() puts the cursor back on the field being edited, after
+// whatever was drawn meanwhile. Echo: with Echo::Driver (default) the
+// form prints what is typed; with Echo::Terminal the terminal does it
+// (TerminalConfig::localEcho) and the form only fixes up corrections
+// and full fields, which saves the echo bytes but needs the cursor to
+// stay on the field: no drawing elsewhere while the form is active.
+class MinitelForm
+{
+public:
+    enum class Echo : uint8_t
+    {
+        Driver,
+        Terminal
+    };
+
+    enum class Status : uint8_t
+    {
+        Editing, // input handled, nothing else pending
+        Sent,    // ENVOI (or CR on the last field): the form is done
+        Key      // an event the form does not handle is waiting
+    };
+
+    explicit MinitelForm(Minitel &dev, Echo echo = Echo::Driver);
+
+    // A field on row 1..24, from column col (1..40), `width` cells wide,
+    // edited in buf (NUL terminated; its content is the initial value).
+    // Returns the field index, or -1 if the form is full.
+    int8_t addField(uint8_t row, uint8_t col, uint8_t width,
+                    char *buf, uint8_t size);
+
+    // Shown in the empty part of each field (default '.')
+    void setFill(char c) { fill_ = c; }
+
+    // Draws every field and starts editing `field`
+    void begin(uint8_t field = 0);
+    void end() { active_ = false; }
+    bool active() const { return active_; }
+
+    // Handles the queued input. Call it from the loop, next to poll().
+    Status update();
+
+    uint8_t focus() const { return focus_; }
+    void setFocus(uint8_t field);
+
+    void clearField(uint8_t field);
+    void drawField(uint8_t field);
+
+private:
+    struct Field
+    {
+        char *buf;
+        uint8_t row, col, width;
+        uint8_t len; // chars in buf
+        uint8_t max; // most chars: min(width, size - 1)
+    };
+
+    enum Action : uint8_t
+    {
+        HANDLED,
+        SENT,
+        NOT_MINE
+    };
+
+    Minitel &dev_;
+    Echo echo_;
+    char fill_ = '.';
+    bool active_ = false;
+    uint8_t focus_ = 0;
+    uint8_t count_ = 0;
+    Field fields_[MINITEL_FORM_MAX_FIELDS];
+
+    Action handle(const Minitel::Event &ev);
+    void insert(uint8_t c);
+    void erase();
+    void placeCursor();
+};
@@ -3,21 +3,63 @@
 #include <Arduino.h>
 #include "Minitel.h"
 
-class MinitelGfx
+// Maximum edge crossings per scanline in filled polygons
+#ifndef MGFX_POLY_MAX_CROSSINGS
+#define MGFX_POLY_MAX_CROSSINGS 16
+#endif
+
+// Shadow framebuffer layout:
+// 0: four byte arrays (mask, colour, and their last flushed copies), 3840 B
+// 1: one 16-bit word per cell (mask, colour, last mask) plus the last
+//    colours packed two per byte, 2400 B, and a side plane for the cells
+//    a word can't hold, see MGFX_COMPACT_SIDE_CELLS. Same flush() output.
+#ifndef MGFX_COMPACT_SHADOW
+#define MGFX_COMPACT_SHADOW 0
+#endif
+
+// Compact layout: cells kept in the side plane (4 bytes each). A word
+// holds a mosaic in its colour, or a blank cell on any background;
+// text, tiles and mosaics on a background take a side cell while they
+// are drawn or shown. Past that many, such cells lose their character
+// (or background), see lostCells().
+#ifndef MGFX_COMPACT_SIDE_CELLS
+#define MGFX_COMPACT_SIDE_CELLS 128
+#endif
+
+// Text plane (drawChar / drawText, tiles), kept in the same shadow
+// cells as the semi-graphics
+#ifndef MGFX_TEXT_PLANE
+#define MGFX_TEXT_PLANE 1
+#endif
+
+// Compile-time packing of sprite rows for SpriteFormat::Packed:
+// write each row as its 0/1 pixels, leftmost first.
+//
+//   static const uint8_t ship[] PROGMEM = {
+//       MGFX_ROW8(0,0,0,1,1,0,0,0),
+//       MGFX_ROW8(0,0,1,1,1,1,0,0),
+//       ...
+//   };
+#define MGFX_ROW8(p0, p1, p2, p3, p4, p5, p6, p7)                       \
+    (uint8_t)((((p0) != 0) << 7) | (((p1) != 0) << 6) |                \
+              (((p2) != 0) << 5) | (((p3) != 0) << 4) |                \
+              (((p4) != 0) << 3) | (((p5) != 0) << 2) |                \
+              (((p6) != 0) << 1) | ((p7) != 0))
+
+#define MGFX_ROW16(p0, p1, p2, p3, p4, p5, p6, p7,                      \
+                   p8, p9, p10, p11, p12, p13, p14, p15)                \
+    MGFX_ROW8(p0, p1, p2, p3, p4, p5, p6, p7),                          \
+    MGFX_ROW8(p8, p9, p10, p11, p12, p13, p14, p15)
+
+class MinitelTiles;
+
+// What every canvas size shares: the screen, the modes and the sprites
+// (a Sprite can be drawn on any canvas).
+class MinitelGfxBase
 {
 public:
-    static constexpr uint8_t CELL_COLS = 40;
-    static constexpr uint8_t CELL_ROWS = 24;
-    static constexpr uint8_t PIXEL_COLS = CELL_COLS * 2; // 80
-    static constexpr uint8_t PIXEL_ROWS = CELL_ROWS * 3; // 72
-
-    static constexpr uint16_t NUM_CELLS = CELL_COLS * CELL_ROWS; // 960
-    static constexpr uint16_t NUM_PIXELS = NUM_CELLS * 6;        // 5760
-
-    explicit MinitelGfx(Minitel &dev);
-
-    // Clear logical bitmap (and optionally clear screen).
-    void clear(bool updateScreen = true);
+    static constexpr uint8_t SCREEN_COLS = 40;
+    static constexpr uint8_t SCREEN_ROWS = 24;
 
     enum class FlushMode : uint8_t
     {
@@ -25,16 +67,232 @@ public:
         OptimizedDiff ///< only update changed chars (with smart path)
     };
 
-    void flush(FlushMode mode = FlushMode::OptimizedDiff);
-
-    // ------------------- Drawing API in pixel space --------------------
     enum class DrawMode : uint8_t
     {
-        BitmapOnly,
-        Immediate
+        BitmapOnly, // drawing stays in the bitmap until flush()
+        Immediate,  // each changed cell is sent at once, pixel by pixel
+        Streaming   // each drawing call ends with a diff of its cells
     };
 
+    enum class SpriteFormat : uint8_t
+    {
+        Bytes,
+        BytesProgmem,
+        Packed,
+        PackedProgmem
+    };
+
+    struct Sprite
+    {
+        const uint8_t *frames = nullptr; // pointer to frame data
+        SpriteFormat format = SpriteFormat::Bytes;
+        uint8_t width = 0;
+        uint8_t height = 0;
+        uint8_t frameCount = 0;
+
+        int16_t x = 0; // current position
+        int16_t y = 0;
+
+        int16_t prevX = 0; // previous position (for erase)
+        int16_t prevY = 0;
+        uint8_t frame = 0;     // current frame index
+        uint8_t prevFrame = 0; // previous frame index
+        // Rotation (degrees)
+        int16_t angleDeg = 0;     // current angle, in degrees
+        int16_t prevAngleDeg = 0; // previous angle, for erase
+    // NEW:
+    uint8_t  scale       = 1;     // 1..N (integer magnification)
+    uint8_t  prevScale   = 1;
+    bool     flipX       = false; // mirror horizontally
+    bool     flipY       = false; // flip vertically
+    bool     prevFlipX   = false;
+    bool     prevFlipY   = false;
+
+        bool visible = true;
+        bool firstDraw = true;
+
+        // Pre-rotated frames, see spriteCacheRotations()
+        const uint8_t *rotCache = nullptr;
+        uint8_t rotSteps = 0;
+        uint8_t rotSide = 0;
+    };
+};
+
+// A canvas of Cols x Rows cells, at most the 40 x 24 screen. MinitelGfx
+// is the full screen; a smaller one takes less RAM (20 x 12: a quarter
+// of the shadow) and is placed on the screen with setOrigin(). The size
+// is a constant of each class, so index math has fixed strides, and
+// canvases of different sizes can be used side by side:
+//
+//   MinitelGfx screen(minitel);
+//   MinitelGfxT<20, 12> widget(minitel);
+//
+// Sizes other than 40 x 24 are built from MinitelGfxImpl.h, once in the
+// sketch (in a single .cpp / .ino):
+//
+//   #include "MinitelGfxImpl.h"
+//   template class MinitelGfxT<20, 12>;
+template <uint8_t Cols, uint8_t Rows>
+class MinitelGfxT : public MinitelGfxBase
+{
+    static_assert(Cols >= 1 && Cols <= SCREEN_COLS && Rows >= 1 && Rows <= SCREEN_ROWS,
+                  "the canvas must fit the 40 x 24 screen");
+#if MGFX_COMPACT_SHADOW
+    static_assert(MGFX_COMPACT_SIDE_CELLS <= 255, "side cells are indexed by a byte");
+#endif
+
+public:
+    // Full screen: 40 x 24 cells, 80 x 72 pixels
+    static constexpr uint8_t CELL_COLS = Cols;
+    static constexpr uint8_t CELL_ROWS = Rows;
+    static constexpr uint8_t PIXEL_COLS = CELL_COLS * 2;
+    static constexpr uint8_t PIXEL_ROWS = CELL_ROWS * 3;
+
+    static constexpr uint16_t NUM_CELLS = CELL_COLS * CELL_ROWS;
+    static constexpr uint16_t NUM_PIXELS = NUM_CELLS * 6;
+
+    explicit MinitelGfxT(Minitel &dev);
+
+    // Screen cell (0-based) of the canvas' top left corner, for one
+    // smaller than the screen; clamped so that it fits. The next flush()
+    // sends the whole canvas there. A canvas narrower than the screen
+    // does not get the cursor wrap from one row to the next, so its
+    // diffs cost a cursor move more per changed row.
+    void setOrigin(uint8_t col, uint8_t row);
+    uint8_t originCol() const { return originCol_; }
+    uint8_t originRow() const { return originRow_; }
+
+    // Clear logical bitmap (and optionally clear screen). A canvas
+    // smaller than the screen is blanked by the next flush() instead.
+    void clear(bool updateScreen = true);
+
+    void flush(FlushMode mode = FlushMode::OptimizedDiff);
+
+    // Bytes flush(mode) would send right now, from the same encoder.
+    // Nothing is sent.
+    uint16_t flushCost(FlushMode mode = FlushMode::OptimizedDiff) const;
+
+    // flush(), but only if its output fits in the TX queue now (or the
+    // queue is empty). Otherwise nothing is sent and changes keep
+    // accumulating, so intermediate frames are coalesced into the next
+    // diff that goes out. `bytes`, if given, receives the estimate.
+    //
+    //   gfx.setFlushBacklog(60);   // at most ~0.5 s behind at 1200 baud
+    //   ...
+    //   drawFrame();
+    //   gfx.flushIfRoom();         // drops frames the link can't keep up with
+    //   minitel.poll();
+    bool flushIfRoom(FlushMode mode = FlushMode::OptimizedDiff,
+                     uint16_t *bytes = nullptr);
+
+    // Most bytes flushIfRoom() lets wait in the TX queue, which bounds
+    // the display latency (default: the whole queue).
+    void setFlushBacklog(uint16_t maxQueued) { maxBacklog_ = maxQueued; }
+
+    // Cell writes since clear() that the compact shadow had no side cell
+    // for: characters and tiles left blank, mosaics drawn on black.
+    // Always 0 with the byte layout.
+    uint16_t lostCells() const { return lostCells_; }
+
+    // ----------------------------- SCENES -----------------------------
+    //
+    // Snapshots of the whole drawing (graphics, text, colours) to switch
+    // screens without repainting: loading one only replaces the bitmap,
+    // and the next diff flush sends the cells that differ from what the
+    // terminal shows, e.g. from the menu to a sub-page sharing its frame.
+    //
+    //   static uint8_t menu[MinitelGfx::SCENE_BYTES];   // RAM
+    //   drawMenu();  gfx.saveScene(menu);
+    //   ...
+    //   gfx.loadScene(menu);
+    //   gfx.flush();                                    // diff only
+    //
+    // In flash, scenes are kept packed (runs of equal bytes; a typical
+    // page packs to a few hundred bytes): packScene() makes the data,
+    // loadPackedScene() reads it. Either MGFX_COMPACT_SHADOW layout loads
+    // the other's scenes; text is dropped without MGFX_TEXT_PLANE.
+    static constexpr uint16_t SCENE_BYTES = 2 * NUM_CELLS;
+
+    void saveScene(uint8_t *buf) const;
+    void loadScene(const uint8_t *buf);
+
+    // Packed size, or 0 if it does not fit in `cap` bytes
+    uint16_t packScene(uint8_t *out, uint16_t cap) const;
+    // False if the data is malformed (the bitmap is then partly loaded)
+    bool loadPackedScene(const uint8_t *data, bool progmem = true);
+
+    // Take the bitmap as what the terminal shows, without sending
+    // anything (e.g. after bytes written by other means).
+    void markFlushed();
+
+    // Static screens with no encoding at all: send `len` precompiled
+    // bytes from flash (a stream that starts with FF, captured from a
+    // flush, see extras/host/pagec), then load the packed scene it draws
+    // so later diffs start from there.
+    void sendCompiled(const uint8_t *stream, uint16_t len,
+                      const uint8_t *packedScene);
+
+    // ---------------------------- SCROLLING ----------------------------
+    //
+    // Move cell rows [row0..row1] up by `lines` (down if negative); the
+    // rows uncovered are blank. For a log or a ticker:
+    //
+    //   gfx.scrollRegion(0, 23, 1);
+    //   gfx.drawText(0, 23, "new line");
+    //   gfx.flush();                    // sends the new line only
+    //
+    // On the whole screen the terminal scrolls by itself (roll mode, an
+    // LF on row 24 or a VT on row 1), and the shadow of what it shows is
+    // moved along, so the next flush() only sends what really differs: a
+    // few bytes plus the new row instead of the whole screen. Roll mode
+    // stays on for the scrolls that follow, until the next flush() (or
+    // Immediate update) turns it off: text printed through the Minitel
+    // in between scrolls at the bottom of the screen. The Minitel 1 can
+    // only roll the whole screen: any other region is moved in the
+    // bitmap and goes out with the next diff.
+    //
+    // Characters cut by the region edges are blanked.
+    void scrollRegion(uint8_t row0, uint8_t row1, int8_t lines);
+
+    // ------------------- Drawing API in pixel space --------------------
     void setDrawMode(DrawMode mode) { drawMode_ = mode; }
+    DrawMode drawMode() const { return drawMode_; }
+
+    // Streaming sends what a drawing call changed when it returns, each
+    // cell once and in path order, as flush() would: a line costs one
+    // write per cell instead of one per pixel with its own cursor move.
+    // With a window, calls are collected until the first change is
+    // `ms` old (checked as each call ends, and by flushIfDue() from the
+    // loop). It goes through flushIfRoom(): when the link is behind,
+    // changes wait and coalesce.
+    //
+    //   gfx.setDrawMode(MinitelGfx::DrawMode::Streaming);
+    //   gfx.setStreamWindow(20);
+    //   gfx.beginBatch();          // optional: several calls as one
+    //   gfx.drawLine(0, 0, 79, 71);
+    //   gfx.drawCircle(40, 36, 20, false);
+    //   gfx.endBatch();
+    //   ...
+    //   gfx.flushIfDue();          // in loop()
+    void setStreamWindow(uint16_t ms) { streamWindowMs_ = ms; }
+    void beginBatch() { ++batchDepth_; }
+    void endBatch();
+
+    // Streaming: flush the pending changes if their window is over.
+    // True if something was sent.
+    bool flushIfDue();
+
+    // Restrict every drawing call to the cells [col0..col1] x [row0..row1]
+    // (inclusive, clamped to the screen). resetClip() restores the screen.
+    void setClipCells(uint8_t col0, uint8_t row0, uint8_t col1, uint8_t row1);
+    void resetClip();
+
+    // Blank the cells [col0..col1] x [row0..row1], within the clip
+    void clearCells(uint8_t col0, uint8_t row0, uint8_t col1, uint8_t row1);
+
+    // Same, on a `bg` background: a coloured panel
+    void fillCells(uint8_t col0, uint8_t row0, uint8_t col1, uint8_t row1,
+                   Minitel::Color bg);
 
     // ... déjà existant ...
     void drawPixel(int x, int y, bool on = true);
@@ -62,10 +320,83 @@ public:
 
     // Optionally, let the user query it
     Minitel::Color drawColor() const { return drawColor_; }
+
+    // Background of the cells drawn from now on (black by default).
+    //
+    // On the Minitel the background is a serial attribute: blank cells,
+    // spaces and semi-graphic cells (the delimiters) carry their own,
+    // and other characters show the one of the nearest delimiter to
+    // their left on the row. So text takes the background of the zone
+    // it is drawn in: on a panel, start it after at least one cell of
+    // the panel, e.g.
+    //
+    //   gfx.fillCells(0, 5, 39, 7, Minitel::Color::Blue);
+    //   gfx.drawText(1, 6, "MENU");     // blue background
+    //
+    // flush() only sends the background escape where a delimiter needs
+    // a different one.
+    void setDrawBgColor(Minitel::Color c) { drawBgColor_ = c; }
+    Minitel::Color drawBgColor() const { return drawBgColor_; }
+
+#if MGFX_TEXT_PLANE
+    // --------------------------- TEXT PLANE ---------------------------
+    //
+    // G0 characters live in the same cells as the semi-graphics and are
+    // diffed by flush() along with them: only changed characters are
+    // sent, with SI / SO and attributes switched where needed.
+    //
+    //   gfx.setDrawColor(Minitel::Color::Yellow);
+    //   gfx.setTextAttributes(Minitel::CharSize::DoubleHeight);
+    //   gfx.drawText(2, 1, "SCORE");
+    //   gfx.setTextAttributes(Minitel::CharSize::Normal);
+    //   gfx.drawText(9, 1, "00120");    // later: only new digits are sent
+    //   gfx.flush();
+    //
+    // Coordinates are 0-based cells. A double height character stands
+    // on its cell and covers the one above (as on the terminal); double
+    // width ones cover the cell to the right. Characters that would not
+    // fit (or not fit the clip) are skipped; double width in the last
+    // column and double height on the first row fall back to normal.
+    // Drawing pixels over a character replaces it; erasing pixels leaves
+    // it, unless the whole cell is erased (e.g. clearCells()).
+
+    // Size, polarity and flash of the next drawChar() / drawText().
+    // The colour is drawColor().
+    void setTextAttributes(Minitel::CharSize size,
+                           bool negative = false, bool flash = false);
+
+    // One character, 0x20..0x7E (anything else is drawn as a space)
+    void drawChar(uint8_t col, uint8_t row, char c);
+
+    // A string on one row, no wrap. Returns the column after it.
+    uint8_t drawText(uint8_t col, uint8_t row, const char *s);
+
+    // ------------------------------ TILES ------------------------------
+    //
+    // 8x10 glyphs from a MinitelTiles (see MinitelTiles.h), one cell
+    // each, drawn like characters in drawColor() with the polarity and
+    // flash of setTextAttributes(). flush() uploads the tiles it needs
+    // first, then sends their DRCS codes, switching between the DRCS
+    // and standard G0 sets (ESC 2/8, 3 or 4 bytes) where it is cheapest,
+    // as it does with SI / SO, so tiles next to each other go in one run.
+    //
+    //   gfx.setTiles(&tiles);
+    //   for (uint8_t col = 0; col < 40; ++col)
+    //       gfx.drawTile(col, 23, BRICK);   // one upload, one REP run
+    //   gfx.flush();
+    //
+    // Scenes keep tile ids: load them with the same MinitelTiles.
+    void setTiles(MinitelTiles *tiles) { tiles_ = tiles; }
+    MinitelTiles *tiles() const { return tiles_; }
+
+    // A tile added to tiles(); ignored without one
+    void drawTile(uint8_t col, uint8_t row, uint8_t id);
+#endif
+
     // ------------------------- SPRITE SUPPORT -------------------------
     //
     // Simple software sprites drawn at pixel level, with minimal state:
-    // - frames: pointer to frame data (frameCount * height * width bytes, 0/1)
+    // - frames: pointer to frame data, see SpriteFormat
     // - width, height: in pixels (Minitel pixel grid: 80x72)
     // - frameCount: number of animation frames
     // - x, y: current top-left pixel position
@@ -87,35 +418,11 @@ public:
     //   gfx.spriteDraw(mush);
     //   gfx.flush(OptimizedDiff);
     //
-    struct Sprite
-    {
-        const uint8_t *frames = nullptr; // pointer to frame data (0/1 bytes)
-        uint8_t width = 0;
-        uint8_t height = 0;
-        uint8_t frameCount = 0;
-
-        int16_t x = 0; // current position
-        int16_t y = 0;
-
-        int16_t prevX = 0; // previous position (for erase)
-        int16_t prevY = 0;
-        uint8_t frame = 0;     // current frame index
-        uint8_t prevFrame = 0; // previous frame index
-        // Rotation (degrees)
-        int16_t angleDeg = 0;     // current angle, in degrees
-        int16_t prevAngleDeg = 0; // previous angle, for erase
-    // NEW:
-    uint8_t  scale       = 1;     // 1..N (integer magnification)
-    uint8_t  prevScale   = 1;
-    bool     flipX       = false; // mirror horizontally
-    bool     flipY       = false; // flip vertically
-    bool     prevFlipX   = false;
-    bool     prevFlipY   = false;
-
-        bool visible = true;
-        bool firstDraw = true;
-    };
-
+    // Frame data layout:
+    // - Bytes:  frameCount * height * width bytes, 0 = off, != 0 = on
+    // - Packed: 1 bit per pixel, MSB = leftmost, each row padded to a
+    //           whole byte: frameCount * height * ((width + 7) / 8) bytes
+    // The *Progmem variants read the same layout from flash.
     // Initialize a sprite with its frames and dimensions.
     // frames: pointer to frameCount*height*width bytes (0=off, !=0=on)
     void spriteInit(Sprite &spr,
@@ -124,6 +431,15 @@ public:
                     uint8_t height,
                     uint8_t frameCount);
 
+    // Same, with an explicit frame layout (e.g. PackedProgmem for
+    // MGFX_ROW8() arrays declared PROGMEM).
+    void spriteInit(Sprite &spr,
+                    const uint8_t *frames,
+                    uint8_t width,
+                    uint8_t height,
+                    uint8_t frameCount,
+                    SpriteFormat format);
+
     // Set current sprite position (top-left pixel)
     void spriteSetPosition(Sprite &spr, int16_t x, int16_t y);
 
@@ -152,48 +468,316 @@ public:
     void spriteSetFlip(Sprite& spr, bool flipX, bool flipY);
     void spriteSetScale(Sprite& spr, uint8_t scale);   // scale>=1 (clamped)
 
+    // Rotation cache: render every frame at `steps` angles evenly spread
+    // over 360 degrees into `buffer` (spriteRotationCacheSize() bytes,
+    // RAM). While set, rotated draws at scale 1 without flips snap to
+    // the nearest cached angle and cost about as much as unrotated ones.
+    static uint16_t spriteRotationCacheSize(const Sprite& spr, uint8_t steps);
+    bool spriteCacheRotations(Sprite& spr, uint8_t* buffer,
+                              uint16_t size, uint8_t steps);
+    void spriteClearRotationCache(Sprite& spr);
+
+    // Draw the current frame/position/transform only: no erase, prev*
+    // fields untouched. For sprite managers such as MinitelSpriteLayer.
+    void spriteBlit(const Sprite& spr, bool on = true);
+
+    // Pixel bounding box of what spriteBlit() would touch (inclusive,
+    // may lie off screen). False if the sprite has nothing to draw.
+    bool spriteBounds(const Sprite& spr,
+                      int16_t &x0, int16_t &y0,
+                      int16_t &x1, int16_t &y1) const;
+
 private:
     Minitel &dev_;
 
+    uint8_t originCol_ = 0;
+    uint8_t originRow_ = 0;
+
     DrawMode drawMode_ = DrawMode::BitmapOnly;
 
+    // Streaming state: drawing calls in progress, and since when
+    // (millis()) changes are waiting
+    uint8_t batchDepth_ = 0;
+    bool streamArmed_ = false;
+    uint16_t streamWindowMs_ = 0;
+    unsigned long streamSince_ = 0;
+
+    // Makes each public drawing call one batch
+    struct Batch
+    {
+        MinitelGfxT &gfx;
+        explicit Batch(MinitelGfxT &g) : gfx(g) { gfx.beginBatch(); }
+        ~Batch() { gfx.endBatch(); }
+    };
+    uint16_t maxBacklog_ = 0xFFFF;
+
+    // Clip rectangle in cells, inclusive
+    uint8_t clipCol0_ = 0;
+    uint8_t clipRow0_ = 0;
+    uint8_t clipCol1_ = CELL_COLS - 1;
+    uint8_t clipRow1_ = CELL_ROWS - 1;
+
+    bool inClip(uint8_t col, uint8_t row) const
+    {
+        return col >= clipCol0_ && col <= clipCol1_ &&
+               row >= clipRow0_ && row <= clipRow1_;
+    }
+
     void updateCellOnScreen(uint8_t col, uint8_t row);
 
+    // Text cells: mask bit 7 set, bits 0-6 hold the G0 character, or
+    // which part of a larger character (owned by another cell) this is.
+    // Their colour byte adds flash and polarity to the foreground.
+    // Colour bits 5-7 hold the background of delimiters (blank, G1 and
+    // space cells, and the parts of larger ones) and stay 0 for other
+    // characters, but tiles: a character 0x21 + the tile id, with
+    // ATTR_TILE set (tileAt() checks both).
+    static constexpr uint8_t CELL_TEXT = 0x80;
+    static constexpr uint8_t TEXT_RIGHT = 0x01;       // owner at k - 1
+    static constexpr uint8_t TEXT_UPPER = 0x02;       // owner at k + CELL_COLS
+    static constexpr uint8_t TEXT_UPPER_RIGHT = 0x03; // owner at k + CELL_COLS - 1
+    static constexpr uint8_t ATTR_FLASH = 0x08;
+    static constexpr uint8_t ATTR_NEGATIVE = 0x10;
+    static constexpr uint8_t ATTR_BG_SHIFT = 5;
+    static constexpr uint8_t ATTR_TILE = 0x20;
+
+    uint8_t textSize_ = 0; // Minitel::CharSize of new characters
+    uint8_t textAttr_ = 0; // ATTR_* of new characters
+
+    bool isText(uint16_t k) const { return (cellMask(k) & CELL_TEXT) != 0; }
+    // True for the cells covered by a larger character
+    bool isTextPart(uint16_t k) const
+    {
+        uint8_t m = cellMask(k);
+        return (m & CELL_TEXT) && (m & 0x7F) < 0x20;
+    }
+    uint16_t textOwner(uint16_t k) const;
+    // Minitel::CharSize of the character owned by cell k, from its parts
+    uint8_t textSize(uint16_t k) const;
+    // Cells of the character owned by k (owner first), returns the count
+    uint8_t textGroup(uint16_t k, uint16_t cells[4]) const;
+    // Blank the rest of the character covering cell k
+    void breakText(uint16_t k);
+    // Blanks the parts whose character got lost (see lostCells()) if
+    // any cell was since `lostBefore`
+    void dropOrphanParts(uint16_t lostBefore);
+    // Cells carrying their own background (serial attribute)
+    bool isDelimiter(uint16_t k) const;
+    // Background cell k shows: its own, or its zone's
+    uint8_t shownBg(uint16_t k) const;
+    void blankCell(uint8_t col, uint8_t row, uint8_t bg);
+    // Graphics drawn over cell k: false if the cell must be left alone
+    // (erasing part of a character), else any character there is gone.
+    bool releaseText(uint16_t k, uint8_t mask, bool on);
+#if MGFX_TEXT_PLANE
+    void putText(uint8_t col, uint8_t row, uint8_t c);
+
+    MinitelTiles *tiles_ = nullptr;
+
+    // Tile id of cell k, or MinitelTiles::NONE
+    uint8_t tileAt(uint16_t k) const;
+    // Tiles the next flush() draws that want an upload, one bit per id.
+    // Returns how many.
+    uint8_t tilesToLoad(bool full, uint8_t *need) const;
+    // Upload them, sparing the codes of the tiles in the bitmap
+    void loadTiles(const uint8_t *need);
+    // Call fn(k) for each cell the next flush() sends
+    template <typename Fn>
+    void forSentCells(bool full, Fn fn) const;
+    // Before flush(): uploads, and the drawn tiles marked as used
+    void prepareTiles(bool full);
+#endif
+
+    uint16_t lostCells_ = 0;
+
+#if MGFX_COMPACT_SHADOW
+    // bits 0-5: mask, 6-8: colour (the background of a blank cell),
+    // 9-14: last flushed mask, 15: last state unknown (the cell is
+    // always re-sent). A side cell's word is its index in side_.
+    uint16_t cell_[NUM_CELLS];
+    // Last flushed colour (or background), low nibble = even cell; the
+    // nibble's bit 3 marks a side cell
+    uint8_t lastCellColor_[(NUM_CELLS + 1) / 2];
+
+    // A cell as the byte layout keeps it (last mask 0xFF: unknown);
+    // mask 0xFF: free
+    struct SideCell
+    {
+        uint8_t mask;
+        uint8_t color;
+        uint8_t lastMask;
+        uint8_t lastColor;
+    };
+    // A canvas with fewer cells never runs out
+    static constexpr uint8_t SIDE_CELLS =
+        (MGFX_COMPACT_SIDE_CELLS < NUM_CELLS) ? MGFX_COMPACT_SIDE_CELLS : NUM_CELLS;
+    SideCell side_[SIDE_CELLS];
+
+    bool isSide(uint16_t k) const
+    {
+        return (lastCellColor_[k >> 1] & ((k & 1) ? 0x80 : 0x08)) != 0;
+    }
+    // What a word holds: a mosaic in its colour, or a blank cell
+    static constexpr bool fitsWord(uint8_t mask, uint8_t color)
+    {
+        return mask <= 0x3F && (mask == 0 || color <= 0x07);
+    }
+    // The last flushed state, through the byte layout
+    void shownState(uint16_t k, uint8_t &mask, uint8_t &color) const;
+    // Store both states, in the word or a side cell as they need
+    void setCellState(uint16_t k, uint8_t mask, uint8_t color,
+                      uint8_t lastMask, uint8_t lastColor);
+    void setShownNibble(uint16_t k, uint8_t bits);
+#else
     uint8_t cellMask_[NUM_CELLS];
     uint8_t lastCellMask_[NUM_CELLS];
     // NEW: per-cell foreground color (index of Minitel::Color)
     uint8_t cellColor_[NUM_CELLS];
     uint8_t lastCellColor_[NUM_CELLS];
+#endif
+
+    // Blank the characters standing across rows row - 1 and row
+    void breakTextAcross(uint8_t row);
+
+    // Byte i of a scene snapshot, and one cell read back from one
+    uint8_t sceneByte(uint16_t i) const;
+    void setSceneCell(uint16_t k, uint8_t mask, uint8_t color);
+
+    // Shadow accessors, the only code aware of the layout
+    uint8_t cellMask(uint16_t k) const;
+    // Last flushed mask (0xFF: unknown)
+    uint8_t shownMask(uint16_t k) const;
+    uint8_t cellColor(uint16_t k) const;
+    void setCell(uint16_t k, uint8_t mask, uint8_t color);
+    // last := current for cells k..k+n-1
+    void syncCells(uint16_t k, uint16_t n);
+    // Blank white bitmap; `known` false forces a full first flush
+    void resetCells(bool known);
+    // The bitmap stays, the terminal's copy is unknown: every cell
+    // differs on the next flush
+    void forgetShown();
+    // Cells src..src+n-1 to dst.., the last flushed state too if `shown`
+    void moveCells(uint16_t dst, uint16_t src, uint16_t n, bool shown);
+    // The terminal shows cells k..k+n-1 blank, on black
+    void blankShownCells(uint16_t k, uint16_t n);
 
     // Color currently used for drawing new pixels
     Minitel::Color drawColor_ = Minitel::Color::White;
+    Minitel::Color drawBgColor_ = Minitel::Color::Black;
+
+    // Colour byte of newly drawn cells
+    uint8_t drawAttr() const
+    {
+        return static_cast<uint8_t>(drawColor_) |
+               (static_cast<uint8_t>(drawBgColor_) << ATTR_BG_SHIFT);
+    }
 
-    // GFX's best guess of the current terminal FG color (for optimization)
-    Minitel::Color termFgColor_ = Minitel::Color::White;
+    // Dirty tracking, kept by setSubPixelByChar() / applyCellMask():
+    // one bit per touched row plus the touched column span of each row.
+    // flush() only compares and syncs these spans.
+    uint32_t dirtyRows_ = 0;
+    uint8_t dirtyMin_[CELL_ROWS];
+    uint8_t dirtyMax_[CELL_ROWS];
 
-    // Current known cursor position (1-based Minitel coords)
-    int curRow_ = 1;
-    int curCol_ = 1;
-    bool hasCursor_ = false; // false until first gotoCell() sets it
+    void markDirty(uint8_t col, uint8_t row);
+    void markAllDirty();
+    void clearDirty();
+
+    // Cursor, charset and colours come from dev_.termState(), which
+    // every Minitel emitter keeps up to date.
 
     // ---------- index helpers (as before) ----------
-    static uint16_t charIndex(uint8_t col, uint8_t row);
-    static uint16_t pixelBaseForChar(uint8_t col, uint8_t row);
-    static uint16_t pixelIndexFromXY(uint8_t x, uint8_t y);
-    static uint8_t subPixelIndexInChar(uint8_t xInChar, uint8_t yInChar);
+    static constexpr uint16_t charIndex(uint8_t col, uint8_t row)
+    {
+        return (uint16_t)row * CELL_COLS + col;
+    }
+    static constexpr uint16_t pixelBaseForChar(uint8_t col, uint8_t row)
+    {
+        return charIndex(col, row) * 6u;
+    }
+    // p1..p6 as:
+    // (0,0)->0, (1,0)->1, (0,1)->2, (1,1)->3, (0,2)->4, (1,2)->5
+    static constexpr uint8_t subPixelIndexInChar(uint8_t xInChar, uint8_t yInChar)
+    {
+        return (uint8_t)(yInChar * 2 + xInChar);
+    }
+    static constexpr uint16_t pixelIndexFromXY(uint8_t x, uint8_t y)
+    {
+        return pixelBaseForChar(x / 2, y / 3) + subPixelIndexInChar(x % 2, y % 3);
+    }
+
+    // 1-based screen position of cell k, as the terminal counts
+    uint8_t screenRow(uint16_t k) const { return originRow_ + k / CELL_COLS + 1; }
+    uint8_t screenCol(uint16_t k) const { return originCol_ + k % CELL_COLS + 1; }
+    // The canvas spans the screen: the cursor wraps from its last
+    // column to the first of the next row. Known at compile time.
+    static constexpr bool fullWidth() { return CELL_COLS == SCREEN_COLS; }
+    static constexpr bool fullScreen()
+    {
+        return fullWidth() && CELL_ROWS == SCREEN_ROWS;
+    }
 
     void setSubPixelByChar(uint8_t col, uint8_t row,
                            uint8_t subIndex, bool on);
 
+    // OR (on) / clear (off) several sub-pixels of one cell at once
+    void applyCellMask(uint8_t col, uint8_t row, uint8_t mask, bool on);
+
     uint8_t maskToG1(uint8_t mask) const;
 
+    // True if cell k differs from what the terminal shows
+    bool cellChanged(uint16_t k) const;
+    // The same character as shown at k, but grown or shrunk
+    bool textResized(uint16_t k) const;
+    // The shadow can hold a character in these cells
+    bool roomForText(const uint16_t *cells, uint8_t n) const;
+
+    // Cell index the next printed char lands on (NUM_CELLS if the
+    // cursor is unknown).
+    uint16_t cursorCell() const;
+
+    // Flush encoder (see MinitelGfxImpl.h): what cell k needs on screen,
+    // and the runs of such glyphs with their SI / SO and attributes.
+    struct Glyph;
+    struct CellEncoder;
+    Glyph glyphAt(uint16_t k) const;
+
     // NEW: optimized move in alpha-cell space
-    void gotoCell(uint8_t row, uint8_t col);
-    void advanceCursorAfterPrint();
+    // Cost helpers take 1-based Minitel coords and only price the move.
+    uint8_t relativeMoveCost(uint16_t from, uint8_t row, uint8_t col) const;
+    // Bytes `enc` will have sent once it has moved from cell `from` to
+    // cell k and drawn it; `absolute` tells whether US (which resets
+    // attributes) wins over relative moves.
+    uint16_t jumpCost(const CellEncoder &enc, uint16_t from, uint16_t k,
+                      bool &absolute) const;
+    // Close the pending run and move to cell k, as priced by jumpCost()
+    void jumpTo(CellEncoder &enc, uint16_t k, bool absolute) const;
+    // Encode changed (or all) cells to `out`, or only count with nullptr.
+    // Returns the byte count, and the cells sent in `changed`; the shadows
+    // are left alone.
+    uint16_t encodeCells(bool full, Minitel *out,
+                         uint16_t *changed = nullptr) const;
 
     void drawLineThick(int x0, int y0, int x1, int y1,
                        uint8_t thickness, bool on);
 
+    // Span engine: coverage of one pixel row, MSB = leftmost pixel
+    struct SpanRow
+    {
+        uint8_t bits[(PIXEL_COLS + 7) / 8];
+        int16_t xmin, xmax; // touched range
+        void set(int16_t xl, int16_t xr); // inclusive, clipped
+    };
+
+    // Call spans(y, row) for each pixel row y0..y1 and apply the result
+    // one cell at a time.
+    template <typename SpanFn>
+    void fillRows(int16_t y0, int16_t y1, SpanFn spans, bool on);
+
+    // Even-odd scanline fill, edges included
+    void fillPolygon(const int16_t *xs, const int16_t *ys,
+                     uint8_t count, bool on);
+
     // Helper to blit one sprite frame at (dstX,dstY) with rotation
 void spriteBlitFrame(const Sprite& spr,
                      int16_t dstX,
@@ -205,4 +789,93 @@ void spriteBlitFrame(const Sprite& spr,
                      bool flipY,
                      bool on);
 
+// Rotation cache helpers
+static uint16_t rotationFrameSize(uint8_t side);
+static uint8_t rotationStep(const Sprite& spr, int16_t angleDeg);
+static bool rotationCached(const Sprite& spr, uint8_t scale,
+                           bool flipX, bool flipY);
+
+// Unrotated, unscaled blit: one 6-bit mask per covered cell
+void spriteBlitCells(const Sprite& spr,
+                     const uint8_t* base,
+                     int16_t dstX,
+                     int16_t dstY,
+                     bool flipX,
+                     bool flipY,
+                     bool on);
+
 };
+
+#if MGFX_COMPACT_SHADOW
+
+template <uint8_t Cols, uint8_t Rows>
+inline uint8_t MinitelGfxT<Cols, Rows>::cellMask(uint16_t k) const
+{
+    if (isSide(k))
+        return side_[cell_[k]].mask;
+    return cell_[k] & 0x3F;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+inline uint8_t MinitelGfxT<Cols, Rows>::cellColor(uint16_t k) const
+{
+    if (isSide(k))
+        return side_[cell_[k]].color;
+    uint8_t c = (cell_[k] >> 6) & 0x07;
+    if (cell_[k] & 0x3F)
+        return c;
+    return static_cast<uint8_t>(Minitel::Color::White) | (c << ATTR_BG_SHIFT);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+inline void MinitelGfxT<Cols, Rows>::setCell(uint16_t k, uint8_t mask, uint8_t color)
+{
+    if (!isSide(k) && fitsWord(mask, color))
+    {
+        uint8_t c = mask ? color : (color >> ATTR_BG_SHIFT);
+        cell_[k] = (cell_[k] & 0xFE00) | mask | ((uint16_t)c << 6);
+        return;
+    }
+    uint8_t lastMask, lastColor;
+    shownState(k, lastMask, lastColor);
+    setCellState(k, mask, color, lastMask, lastColor);
+}
+
+#else
+
+template <uint8_t Cols, uint8_t Rows>
+inline uint8_t MinitelGfxT<Cols, Rows>::cellMask(uint16_t k) const
+{
+    return cellMask_[k];
+}
+
+template <uint8_t Cols, uint8_t Rows>
+inline uint8_t MinitelGfxT<Cols, Rows>::cellColor(uint16_t k) const
+{
+    return cellColor_[k];
+}
+
+template <uint8_t Cols, uint8_t Rows>
+inline void MinitelGfxT<Cols, Rows>::setCell(uint16_t k, uint8_t mask, uint8_t color)
+{
+    cellMask_[k] = mask;
+    cellColor_[k] = color;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+inline uint8_t MinitelGfxT<Cols, Rows>::shownMask(uint16_t k) const
+{
+    return lastCellMask_[k];
+}
+
+template <uint8_t Cols, uint8_t Rows>
+inline bool MinitelGfxT<Cols, Rows>::roomForText(const uint16_t *, uint8_t) const
+{
+    return true;
+}
+
+#endif
+
+// The full screen canvas, built in MinitelGfx.cpp
+extern template class MinitelGfxT<MinitelGfxBase::SCREEN_COLS, MinitelGfxBase::SCREEN_ROWS>;
+typedef MinitelGfxT<MinitelGfxBase::SCREEN_COLS, MinitelGfxBase::SCREEN_ROWS> MinitelGfx;
@@ -0,0 +1,2778 @@
+#pragma once
+
+// MinitelGfxT's code. MinitelGfx.cpp builds the full screen size with
+// it; include it in one file of the sketch to build another, see
+// MinitelGfx.h.
+
+#include "MinitelGfx.h"
+#include "MinitelTiles.h"
+#include <string.h>
+
+static int16_t normalizeAngleDeg(int16_t a)
+{
+    // Keep angle in range [0,360)
+    int16_t r = a % 360;
+    if (r < 0)
+        r += 360;
+    return r;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+MinitelGfxT<Cols, Rows>::MinitelGfxT(Minitel &dev)
+    : dev_(dev)
+{
+    // Blank bitmap, last state unknown: force full refresh on first flush
+    resetCells(false);
+    markAllDirty();
+    drawColor_ = Minitel::Color::White;
+}
+
+// ---------------------- Index helpers -------------------------
+
+// Bit pair (left pixel = MSB) -> cell mask bits (left pixel = low bit)
+static const uint8_t PAIR_TO_MASK[4] = {0x0, 0x2, 0x1, 0x3};
+
+// ---------------------- Bitmap management -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::clear(bool updateScreen)
+{
+    if (updateScreen && !fullScreen())
+    {
+        // FF would clear around the canvas too: resend it all, blank
+        resetCells(false);
+        markAllDirty();
+        return;
+    }
+
+    // Clear logical bitmap, all white by default
+    resetCells(true);
+    clearDirty();
+
+    if (updateScreen)
+    {
+        // Fast clear on the terminal (FF also homes the cursor)
+        dev_.clearScreen();
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::setOrigin(uint8_t col, uint8_t row)
+{
+    originCol_ = (col < SCREEN_COLS - CELL_COLS) ? col : SCREEN_COLS - CELL_COLS;
+    originRow_ = (row < SCREEN_ROWS - CELL_ROWS) ? row : SCREEN_ROWS - CELL_ROWS;
+
+    // Nothing of the canvas is shown at the new place yet
+    forgetShown();
+    markAllDirty();
+}
+
+// ---------------------- Shadow storage -------------------------
+
+#if MGFX_COMPACT_SHADOW
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::setShownNibble(uint16_t k, uint8_t bits)
+{
+    uint8_t &pair = lastCellColor_[k >> 1];
+    uint8_t shift = (k & 1) ? 4 : 0;
+    pair = (pair & ~(0x0F << shift)) | (bits << shift);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::shownState(uint16_t k, uint8_t &mask, uint8_t &color) const
+{
+    if (isSide(k))
+    {
+        mask = side_[cell_[k]].lastMask;
+        color = side_[cell_[k]].lastColor;
+        return;
+    }
+    const uint8_t white = static_cast<uint8_t>(Minitel::Color::White);
+    uint16_t w = cell_[k];
+    uint8_t c = (lastCellColor_[k >> 1] >> ((k & 1) ? 4 : 0)) & 0x07;
+    mask = (w & 0x8000) ? 0xFF : (w >> 9) & 0x3F;
+    color = (mask != 0 && mask != 0xFF) ? c : white | (c << ATTR_BG_SHIFT);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::shownMask(uint16_t k) const
+{
+    uint8_t mask, color;
+    shownState(k, mask, color);
+    return mask;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::setCellState(uint16_t k, uint8_t mask, uint8_t color,
+                                           uint8_t lastMask, uint8_t lastColor)
+{
+    const bool lastFits = lastMask == 0xFF || fitsWord(lastMask, lastColor);
+    uint8_t e = SIDE_CELLS;
+    if (isSide(k))
+    {
+        e = cell_[k];
+    }
+    else if (!fitsWord(mask, color) || !lastFits)
+    {
+        for (e = 0; e < SIDE_CELLS && side_[e].mask != 0xFF; ++e)
+        {
+        }
+    }
+
+    if (e < SIDE_CELLS && (!fitsWord(mask, color) || !lastFits))
+    {
+        side_[e].mask = mask;
+        side_[e].color = color;
+        side_[e].lastMask = lastMask;
+        side_[e].lastColor = lastColor;
+        cell_[k] = e;
+        setShownNibble(k, 0x08);
+        return;
+    }
+
+    // Both fit a word (the side cell is free again), or no side cell is
+    // left: the terminal's copy is resent, what it can't hold is dropped
+    if (e < SIDE_CELLS)
+        side_[e].mask = 0xFF;
+    if (!lastFits)
+        lastMask = 0xFF;
+    if (!fitsWord(mask, color))
+    {
+        ++lostCells_;
+        if (mask > 0x3F)
+        {
+            // Spaces and parts keep their background
+            uint8_t bg = ((mask & 0x7F) <= ' ') ? color >> ATTR_BG_SHIFT : 0;
+            mask = 0;
+            color = bg << ATTR_BG_SHIFT;
+        }
+        color &= mask ? 0x07 : 0xE0;
+    }
+
+    uint8_t c = mask ? color : color >> ATTR_BG_SHIFT;
+    uint16_t w = mask | ((uint16_t)c << 6);
+    uint8_t last = 0;
+    if (lastMask == 0xFF)
+        w |= 0x8000;
+    else
+    {
+        w |= (uint16_t)lastMask << 9;
+        last = lastMask ? lastColor & 0x07 : lastColor >> ATTR_BG_SHIFT;
+    }
+    cell_[k] = w;
+    setShownNibble(k, last);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::roomForText(const uint16_t *cells, uint8_t n) const
+{
+    // Cells already in the side plane keep theirs
+    uint8_t need = 0;
+    for (uint8_t i = 0; i < n; ++i)
+        if (!isSide(cells[i]))
+            ++need;
+    for (uint8_t e = 0; e < SIDE_CELLS && need; ++e)
+        if (side_[e].mask == 0xFF)
+            --need;
+    return need == 0;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::syncCells(uint16_t k, uint16_t n)
+{
+    for (uint16_t end = k + n; k < end; ++k)
+    {
+        if (isSide(k))
+        {
+            // Back to the word once it fits again
+            const SideCell &s = side_[cell_[k]];
+            setCellState(k, s.mask, s.color, s.mask, s.color);
+            continue;
+        }
+        uint16_t w = cell_[k];
+        cell_[k] = (w & 0x01FF) | ((w & 0x3F) << 9);
+        setShownNibble(k, (w >> 6) & 0x07);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::resetCells(bool known)
+{
+    // Blank on black
+    for (uint16_t k = 0; k < NUM_CELLS; ++k)
+        cell_[k] = known ? 0 : 0x8000;
+    memset(lastCellColor_, 0, sizeof(lastCellColor_));
+    for (uint8_t e = 0; e < SIDE_CELLS; ++e)
+        side_[e].mask = 0xFF;
+    lostCells_ = 0;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::forgetShown()
+{
+    for (uint16_t k = 0; k < NUM_CELLS; ++k)
+    {
+        if (isSide(k))
+            side_[cell_[k]].lastMask = 0xFF;
+        else
+            cell_[k] |= 0x8000;
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::moveCells(uint16_t dst, uint16_t src, uint16_t n, bool shown)
+{
+    const uint16_t keep = shown ? 0 : 0xFE00;
+    auto move = [&](uint16_t i)
+    {
+        uint16_t from = src + i, to = dst + i;
+        if (isSide(from) || isSide(to))
+        {
+            uint8_t lastMask, lastColor;
+            shownState(shown ? from : to, lastMask, lastColor);
+            setCellState(to, cellMask(from), cellColor(from), lastMask, lastColor);
+            return;
+        }
+        cell_[to] = (cell_[to] & keep) | (cell_[from] & ~keep);
+        if (shown)
+            setShownNibble(to, (lastCellColor_[from >> 1] >> ((from & 1) ? 4 : 0)) & 0x0F);
+    };
+    // Overlapping ranges: copy away from the destination
+    if (dst < src)
+        for (uint16_t i = 0; i < n; ++i)
+            move(i);
+    else
+        for (uint16_t i = n; i-- > 0;)
+            move(i);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::blankShownCells(uint16_t k, uint16_t n)
+{
+    // Last mask 0 on black, known
+    for (uint16_t end = k + n; k < end; ++k)
+    {
+        if (isSide(k))
+        {
+            const SideCell &s = side_[cell_[k]];
+            setCellState(k, s.mask, s.color, 0,
+                         static_cast<uint8_t>(Minitel::Color::White));
+            continue;
+        }
+        cell_[k] &= 0x01FF;
+        setShownNibble(k, 0);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::cellChanged(uint16_t k) const
+{
+    if (isSide(k))
+    {
+        const SideCell &s = side_[cell_[k]];
+        if (s.mask != s.lastMask)
+            return true;
+        if (s.mask == 0)
+            return ((s.color ^ s.lastColor) >> ATTR_BG_SHIFT) != 0;
+        return s.color != s.lastColor || textResized(k);
+    }
+    uint16_t w = cell_[k];
+    if (w & 0x8000)
+        return true;
+    if ((w & 0x3F) != ((w >> 9) & 0x3F))
+        return true;
+    // A mosaic's colour, or a blank cell's background
+    uint8_t last = (lastCellColor_[k >> 1] >> ((k & 1) ? 4 : 0)) & 0x07;
+    return ((w >> 6) & 0x07) != last;
+}
+
+#else
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::syncCells(uint16_t k, uint16_t n)
+{
+    memcpy(&lastCellMask_[k], &cellMask_[k], n);
+    memcpy(&lastCellColor_[k], &cellColor_[k], n);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::resetCells(bool known)
+{
+    memset(cellMask_, 0, sizeof(cellMask_));
+    // 0xFF matches no mask: every cell differs on the next flush
+    memset(lastCellMask_, known ? 0 : 0xFF, sizeof(lastCellMask_));
+    memset(cellColor_, static_cast<uint8_t>(Minitel::Color::White), sizeof(cellColor_));
+    memset(lastCellColor_, static_cast<uint8_t>(Minitel::Color::White), sizeof(lastCellColor_));
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::forgetShown()
+{
+    memset(lastCellMask_, 0xFF, sizeof(lastCellMask_));
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::moveCells(uint16_t dst, uint16_t src, uint16_t n, bool shown)
+{
+    memmove(&cellMask_[dst], &cellMask_[src], n);
+    memmove(&cellColor_[dst], &cellColor_[src], n);
+    if (shown)
+    {
+        memmove(&lastCellMask_[dst], &lastCellMask_[src], n);
+        memmove(&lastCellColor_[dst], &lastCellColor_[src], n);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::blankShownCells(uint16_t k, uint16_t n)
+{
+    memset(&lastCellMask_[k], 0, n);
+    memset(&lastCellColor_[k], static_cast<uint8_t>(Minitel::Color::White), n);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::cellChanged(uint16_t k) const
+{
+    uint8_t mask = cellMask_[k];
+    if (mask != lastCellMask_[k])
+        return true;
+    // Colour only matters when some sub-pixel is lit, else the background
+    if (mask == 0)
+        return ((cellColor_[k] ^ lastCellColor_[k]) >> ATTR_BG_SHIFT) != 0;
+    return cellColor_[k] != lastCellColor_[k] || textResized(k);
+}
+
+#endif
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::textResized(uint16_t k) const
+{
+    uint8_t mask = cellMask(k);
+    if (!(mask & CELL_TEXT) || (mask & 0x7F) < 0x20)
+        return false;
+
+    // Same character, but it may have grown or shrunk
+    uint8_t last = 0;
+    if (k >= CELL_COLS && shownMask(k - CELL_COLS) == (CELL_TEXT | TEXT_UPPER))
+        last |= 1;
+    if (k % CELL_COLS != CELL_COLS - 1 && shownMask(k + 1) == (CELL_TEXT | TEXT_RIGHT))
+        last |= 2;
+    return textSize(k) != last;
+}
+
+// ---------------------- Dirty tracking -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::markDirty(uint8_t col, uint8_t row)
+{
+    dirtyRows_ |= (1UL << row);
+    if (col < dirtyMin_[row])
+        dirtyMin_[row] = col;
+    if (col > dirtyMax_[row])
+        dirtyMax_[row] = col;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::markAllDirty()
+{
+    dirtyRows_ = (1UL << CELL_ROWS) - 1;
+    memset(dirtyMin_, 0, sizeof(dirtyMin_));
+    memset(dirtyMax_, CELL_COLS - 1, sizeof(dirtyMax_));
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::clearDirty()
+{
+    dirtyRows_ = 0;
+    memset(dirtyMin_, 0xFF, sizeof(dirtyMin_));
+    memset(dirtyMax_, 0, sizeof(dirtyMax_));
+}
+
+// ---------------------- Clipping -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::setClipCells(uint8_t col0, uint8_t row0,
+                              uint8_t col1, uint8_t row1)
+{
+    if (col0 > col1) { uint8_t t = col0; col0 = col1; col1 = t; }
+    if (row0 > row1) { uint8_t t = row0; row0 = row1; row1 = t; }
+    if (col1 >= CELL_COLS) col1 = CELL_COLS - 1;
+    if (row1 >= CELL_ROWS) row1 = CELL_ROWS - 1;
+
+    clipCol0_ = col0;
+    clipRow0_ = row0;
+    clipCol1_ = col1;
+    clipRow1_ = row1;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::resetClip()
+{
+    clipCol0_ = 0;
+    clipRow0_ = 0;
+    clipCol1_ = CELL_COLS - 1;
+    clipRow1_ = CELL_ROWS - 1;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::clearCells(uint8_t col0, uint8_t row0,
+                            uint8_t col1, uint8_t row1)
+{
+    Batch batch(*this);
+    if (col0 < clipCol0_) col0 = clipCol0_;
+    if (row0 < clipRow0_) row0 = clipRow0_;
+    if (col1 > clipCol1_) col1 = clipCol1_;
+    if (row1 > clipRow1_) row1 = clipRow1_;
+
+    for (uint8_t row = row0; row <= row1; ++row)
+        for (uint8_t col = col0; col <= col1; ++col)
+            blankCell(col, row, static_cast<uint8_t>(Minitel::Color::Black));
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::fillCells(uint8_t col0, uint8_t row0,
+                           uint8_t col1, uint8_t row1, Minitel::Color bg)
+{
+    Batch batch(*this);
+    if (col0 < clipCol0_) col0 = clipCol0_;
+    if (row0 < clipRow0_) row0 = clipRow0_;
+    if (col1 > clipCol1_) col1 = clipCol1_;
+    if (row1 > clipRow1_) row1 = clipRow1_;
+
+    for (uint8_t row = row0; row <= row1; ++row)
+        for (uint8_t col = col0; col <= col1; ++col)
+            blankCell(col, row, static_cast<uint8_t>(bg));
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::blankCell(uint8_t col, uint8_t row, uint8_t bg)
+{
+    if (!inClip(col, row))
+        return;
+
+    uint16_t k = charIndex(col, row);
+    breakText(k);
+    markDirty(col, row);
+    setCell(k, 0, static_cast<uint8_t>(Minitel::Color::White) |
+                  (bg << ATTR_BG_SHIFT));
+
+    if (drawMode_ == DrawMode::Immediate)
+    {
+        updateCellOnScreen(col, row);
+    }
+}
+
+// ---------------------- Streaming -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::endBatch()
+{
+    if (batchDepth_ == 0 || --batchDepth_ > 0 ||
+        drawMode_ != DrawMode::Streaming)
+        return;
+
+    if (dirtyRows_ == 0)
+    {
+        streamArmed_ = false;
+        return;
+    }
+    if (!streamArmed_)
+    {
+        streamArmed_ = true;
+        streamSince_ = millis();
+    }
+    flushIfDue();
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::flushIfDue()
+{
+    if (!streamArmed_ || dirtyRows_ == 0 ||
+        (uint16_t)(millis() - streamSince_) < streamWindowMs_)
+        return false;
+    if (dev_.txQueued() > 0)
+        return flushIfRoom();
+    flush();
+    return true;
+}
+
+// ---------------------- Scrolling -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::breakTextAcross(uint8_t row)
+{
+    if (row == 0 || row >= CELL_ROWS)
+        return;
+    // Double height characters stand on their lower row
+    for (uint8_t col = 0; col < CELL_COLS; ++col)
+    {
+        uint16_t k = charIndex(col, row);
+        if (isText(k) && textOwner(k) == k && (textSize(k) & 1))
+            breakText(k);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::scrollRegion(uint8_t row0, uint8_t row1, int8_t lines)
+{
+    Batch batch(*this);
+    if (row1 >= CELL_ROWS)
+        row1 = CELL_ROWS - 1;
+    if (row0 > row1 || lines == 0)
+        return;
+
+    uint8_t height = row1 - row0 + 1;
+    bool up = lines > 0;
+    uint8_t n = up ? lines : -lines;
+    if (n > height)
+        n = height;
+
+    // No character may end up half inside: the region edges, and the
+    // line between the rows that leave and those that stay
+    breakTextAcross(row0);
+    breakTextAcross(row1 + 1);
+    if (n < height)
+        breakTextAcross(up ? row0 + n : row1 + 1 - n);
+
+    // Roll mode works on the whole screen only
+    bool native = fullScreen() && row0 == 0 && row1 == CELL_ROWS - 1 && n < height;
+    if (native)
+    {
+        // Left on for the next scrolls, off again with the next flush()
+        dev_.setRollMode(true);
+        dev_.setCursor(up ? SCREEN_ROWS : 1, 1);
+        for (uint8_t i = 0; i < n; ++i)
+            dev_.writeRaw(up ? 0x0A : 0x0B); // LF / VT past the edge
+    }
+
+    uint16_t lost = lostCells_;
+    uint16_t kept = (uint16_t)(height - n) * CELL_COLS;
+    uint16_t top = charIndex(0, row0);
+    uint16_t shift = (uint16_t)n * CELL_COLS;
+    uint16_t exposed = up ? top + kept : top;
+    if (kept)
+    {
+        if (up)
+            moveCells(top, top + shift, kept, native);
+        else
+            moveCells(top + shift, top, kept, native);
+    }
+    for (uint16_t k = exposed; k < exposed + shift; ++k)
+        setCell(k, 0, static_cast<uint8_t>(Minitel::Color::White));
+    if (native)
+        blankShownCells(exposed, shift);
+    dropOrphanParts(lost);
+
+    for (uint8_t row = row0; row <= row1; ++row)
+    {
+        markDirty(0, row);
+        markDirty(CELL_COLS - 1, row);
+    }
+
+    if (drawMode_ == DrawMode::Immediate)
+        flush();
+}
+
+// ---------------------- Scenes -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::sceneByte(uint16_t i) const
+{
+    // Plane of masks, then plane of colour bytes
+    if (i < NUM_CELLS)
+        return cellMask(i);
+    return cellColor(i - NUM_CELLS);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::saveScene(uint8_t *buf) const
+{
+    for (uint16_t i = 0; i < SCENE_BYTES; ++i)
+        buf[i] = sceneByte(i);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::loadScene(const uint8_t *buf)
+{
+    uint16_t lost = lostCells_;
+    for (uint16_t k = 0; k < NUM_CELLS; ++k)
+        setSceneCell(k, buf[k], buf[NUM_CELLS + k]);
+    dropOrphanParts(lost);
+    markAllDirty();
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::setSceneCell(uint16_t k, uint8_t mask, uint8_t color)
+{
+#if !MGFX_TEXT_PLANE
+    // Saved with the text plane: characters can't be shown here
+    if (mask & CELL_TEXT)
+        mask = 0;
+#endif
+    setCell(k, mask, color);
+}
+
+// PackBits-style runs over the SCENE_BYTES sequence:
+//   n < 0x80:  n + 1 literal bytes follow
+//   n >= 0x80: the next byte, repeated n - 0x80 + 3 times (3..130)
+template <uint8_t Cols, uint8_t Rows>
+uint16_t MinitelGfxT<Cols, Rows>::packScene(uint8_t *out, uint16_t cap) const
+{
+    uint16_t n = 0;
+    uint16_t i = 0;
+    while (i < SCENE_BYTES)
+    {
+        uint8_t b = sceneByte(i);
+        uint16_t run = 1;
+        while (i + run < SCENE_BYTES && run < 130 && sceneByte(i + run) == b)
+            ++run;
+
+        if (run >= 3)
+        {
+            if (n + 2 > cap)
+                return 0;
+            out[n++] = 0x80 + (run - 3);
+            out[n++] = b;
+            i += run;
+            continue;
+        }
+
+        // Literals up to the next run of 3
+        uint16_t start = i;
+        uint16_t len = 0;
+        while (i < SCENE_BYTES && len < 128)
+        {
+            uint8_t c = sceneByte(i);
+            if (i + 2 < SCENE_BYTES && sceneByte(i + 1) == c &&
+                sceneByte(i + 2) == c)
+                break;
+            ++i;
+            ++len;
+        }
+        if (n + 1 + len > cap)
+            return 0;
+        out[n++] = len - 1;
+        for (uint16_t j = 0; j < len; ++j)
+            out[n++] = sceneByte(start + j);
+    }
+    return n;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::loadPackedScene(const uint8_t *data, bool progmem)
+{
+    // Decoded straight into the cells: the mask plane, then the colours
+    uint16_t lost = lostCells_;
+    uint16_t i = 0;
+    uint16_t p = 0;
+    auto next = [&]() -> uint8_t
+    {
+        return progmem ? pgm_read_byte(data + p++) : data[p++];
+    };
+    auto put = [&](uint8_t b)
+    {
+        if (i < NUM_CELLS)
+            setSceneCell(i, b, cellColor(i));
+        else
+            setSceneCell(i - NUM_CELLS, cellMask(i - NUM_CELLS), b);
+        ++i;
+    };
+
+    while (i < SCENE_BYTES)
+    {
+        uint8_t ctrl = next();
+        if (ctrl < 0x80)
+        {
+            uint16_t len = ctrl + 1;
+            if (i + len > SCENE_BYTES)
+                break;
+            while (len--)
+                put(next());
+        }
+        else
+        {
+            uint16_t len = ctrl - 0x80 + 3;
+            if (i + len > SCENE_BYTES)
+                break;
+            uint8_t b = next();
+            while (len--)
+                put(b);
+        }
+    }
+
+    dropOrphanParts(lost);
+    markAllDirty();
+    return i == SCENE_BYTES;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::markFlushed()
+{
+    syncCells(0, NUM_CELLS);
+    clearDirty();
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::sendCompiled(const uint8_t *stream, uint16_t len,
+                              const uint8_t *packedScene)
+{
+    dev_.setRollMode(false);
+    dev_.writeProgmem(stream, len);
+    if (packedScene)
+    {
+        loadPackedScene(packedScene, true);
+        markFlushed();
+    }
+}
+
+// ---------------------- Text plane -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+uint16_t MinitelGfxT<Cols, Rows>::textOwner(uint16_t k) const
+{
+    switch (cellMask(k))
+    {
+    case CELL_TEXT | TEXT_RIGHT:
+        return k - 1;
+    case CELL_TEXT | TEXT_UPPER:
+        return k + CELL_COLS;
+    case CELL_TEXT | TEXT_UPPER_RIGHT:
+        return k + CELL_COLS - 1;
+    default:
+        return k;
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::textSize(uint16_t k) const
+{
+    // Bit 0: double height, bit 1: double width, as Minitel::CharSize
+    uint8_t size = 0;
+    if (k >= CELL_COLS && cellMask(k - CELL_COLS) == (CELL_TEXT | TEXT_UPPER))
+        size |= 1;
+    if (k % CELL_COLS != CELL_COLS - 1 && cellMask(k + 1) == (CELL_TEXT | TEXT_RIGHT))
+        size |= 2;
+    return size;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::textGroup(uint16_t k, uint16_t cells[4]) const
+{
+    uint8_t n = 0;
+    cells[n++] = k;
+    if (!isText(k))
+        return n;
+
+    uint8_t size = textSize(k);
+    if (size & 2)
+        cells[n++] = k + 1;
+    if (size & 1)
+        cells[n++] = k - CELL_COLS;
+    if (size == 3)
+        cells[n++] = k - CELL_COLS + 1;
+    return n;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::isDelimiter(uint16_t k) const
+{
+    if (!isText(k))
+        return true;
+    return (cellMask(textOwner(k)) & 0x7F) == ' ';
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::shownBg(uint16_t k) const
+{
+    // Zone background: the nearest delimiter on the left, else black
+    uint16_t first = k - k % CELL_COLS;
+    for (;;)
+    {
+        if (isDelimiter(k))
+            return cellColor(k) >> ATTR_BG_SHIFT;
+        if (k == first)
+            return static_cast<uint8_t>(Minitel::Color::Black);
+        --k;
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::breakText(uint16_t k)
+{
+    if (!isText(k))
+        return;
+
+    // Blanks in the background shown so far, owner first: its parts are
+    // on its right or above, so their zone is already settled
+    uint16_t cells[4];
+    uint8_t n = textGroup(textOwner(k), cells);
+    for (uint8_t i = 0; i < n; ++i)
+    {
+        uint8_t bg = shownBg(cells[i]);
+        setCell(cells[i], 0, static_cast<uint8_t>(Minitel::Color::White) |
+                             (bg << ATTR_BG_SHIFT));
+        markDirty(cells[i] % CELL_COLS, cells[i] / CELL_COLS);
+    }
+
+    // Cell k itself is about to be redrawn by the caller
+    if (drawMode_ == DrawMode::Immediate)
+    {
+        for (uint8_t i = 0; i < n; ++i)
+            if (cells[i] != k)
+                updateCellOnScreen(cells[i] % CELL_COLS, cells[i] / CELL_COLS);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::dropOrphanParts(uint16_t lostBefore)
+{
+    if (lostCells_ == lostBefore)
+        return;
+
+    for (uint16_t k = 0; k < NUM_CELLS; ++k)
+    {
+        if (!isTextPart(k))
+            continue;
+        // A part on the edge may point off the canvas
+        uint16_t o = textOwner(k);
+        uint16_t cells[4];
+        uint8_t n = (o < NUM_CELLS && !isTextPart(o)) ? textGroup(o, cells) : 0;
+        bool owned = false;
+        for (uint8_t i = 1; i < n; ++i)
+            owned |= (cells[i] == k);
+        if (owned)
+            continue;
+        setCell(k, 0, static_cast<uint8_t>(Minitel::Color::White));
+        markDirty(k % CELL_COLS, k / CELL_COLS);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::releaseText(uint16_t k, uint8_t mask, bool on)
+{
+    if (!isText(k))
+        return true;
+
+    // Erasing stray pixels (e.g. a sprite's old position) keeps the text
+    if (!on && (mask & 0x3F) != 0x3F)
+        return false;
+
+    breakText(k);
+    return true;
+}
+
+#if MGFX_TEXT_PLANE
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::setTextAttributes(Minitel::CharSize size,
+                                   bool negative, bool flash)
+{
+    textSize_ = static_cast<uint8_t>(size);
+    textAttr_ = (negative ? ATTR_NEGATIVE : 0) | (flash ? ATTR_FLASH : 0);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::putText(uint8_t col, uint8_t row, uint8_t c)
+{
+    uint8_t size = textSize_;
+    if (col == CELL_COLS - 1)
+        size &= ~2; // no room for the right half
+    if (row == 0)
+        size &= ~1; // nor for the upper half
+
+    // Owner first, then the parts it covers
+    uint16_t k = charIndex(col, row);
+    uint16_t cells[4] = {k};
+    uint8_t parts[4] = {0};
+    uint8_t n = 1;
+    if (size & 2)
+    {
+        cells[n] = k + 1;
+        parts[n++] = TEXT_RIGHT;
+    }
+    if (size & 1)
+    {
+        cells[n] = k - CELL_COLS;
+        parts[n++] = TEXT_UPPER;
+    }
+    if (size == 3)
+    {
+        cells[n] = k - CELL_COLS + 1;
+        parts[n++] = TEXT_UPPER_RIGHT;
+    }
+
+    for (uint8_t i = 0; i < n; ++i)
+        if (!inClip(cells[i] % CELL_COLS, cells[i] / CELL_COLS))
+            return;
+
+    // Only spaces carry a background, other characters take the zone's
+    uint8_t attr = static_cast<uint8_t>(drawColor_) | textAttr_;
+    if (c == ' ')
+        attr |= static_cast<uint8_t>(drawBgColor_) << ATTR_BG_SHIFT;
+    const bool blank = c == ' ' && size == 0 && !(attr & ATTR_NEGATIVE);
+
+    // All of it or nothing, so no part is left without its character
+    if (!blank && !roomForText(cells, n))
+    {
+        lostCells_ += n;
+        return;
+    }
+
+    for (uint8_t i = 0; i < n; ++i)
+    {
+        breakText(cells[i]);
+        markDirty(cells[i] % CELL_COLS, cells[i] / CELL_COLS);
+    }
+
+    if (blank)
+    {
+        // Plain space: same as a blank cell, which any charset can send
+        setCell(k, 0, drawAttr());
+    }
+    else
+    {
+        setCell(k, CELL_TEXT | c, attr);
+        for (uint8_t i = 1; i < n; ++i)
+            setCell(cells[i], CELL_TEXT | parts[i], attr);
+    }
+
+    // The owner brings its parts along
+    if (drawMode_ == DrawMode::Immediate)
+        updateCellOnScreen(col, row);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawChar(uint8_t col, uint8_t row, char c)
+{
+    Batch batch(*this);
+    if (col >= CELL_COLS || row >= CELL_ROWS)
+        return;
+
+    uint8_t ch = static_cast<uint8_t>(c);
+    if (ch < 0x20 || ch > 0x7E)
+        ch = ' ';
+    putText(col, row, ch);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::drawText(uint8_t col, uint8_t row, const char *s)
+{
+    Batch batch(*this);
+    uint8_t step = (textSize_ & 2) ? 2 : 1;
+    while (s && *s && col < CELL_COLS)
+    {
+        drawChar(col, row, *s++);
+        col += step;
+    }
+    return (col < CELL_COLS) ? col : CELL_COLS;
+}
+
+// ---------------------- Tiles -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::tileAt(uint16_t k) const
+{
+    // Spaces and parts carry a background there, other characters don't
+    uint8_t mask = cellMask(k);
+    uint8_t c = mask & 0x7F;
+    if (!(mask & CELL_TEXT) || c <= ' ' || c > 0x7E ||
+        !(cellColor(k) & ATTR_TILE))
+        return MinitelTiles::NONE;
+    return c - MinitelTiles::FIRST_CODE;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawTile(uint8_t col, uint8_t row, uint8_t id)
+{
+    Batch batch(*this);
+    if (!tiles_ || id >= tiles_->size() ||
+        col >= CELL_COLS || row >= CELL_ROWS || !inClip(col, row))
+        return;
+
+    uint16_t k = charIndex(col, row);
+    breakText(k);
+    markDirty(col, row);
+    setCell(k, CELL_TEXT | (MinitelTiles::FIRST_CODE + id),
+            static_cast<uint8_t>(drawColor_) | textAttr_ | ATTR_TILE);
+
+    if (drawMode_ == DrawMode::Immediate && cellChanged(k))
+    {
+        if (tiles_->wantsCode(id))
+        {
+            uint8_t need[MinitelTiles::TILE_SET_BYTES] = {0};
+            need[id / 8] = 1u << (id % 8);
+            loadTiles(need);
+        }
+        tiles_->touch(id);
+        updateCellOnScreen(col, row);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+template <typename Fn>
+void MinitelGfxT<Cols, Rows>::forSentCells(bool full, Fn fn) const
+{
+    for (uint8_t row = 0; row < CELL_ROWS; ++row)
+    {
+        if (!full && !(dirtyRows_ & (1UL << row)))
+            continue;
+        uint8_t c0 = full ? 0 : dirtyMin_[row];
+        uint8_t c1 = full ? CELL_COLS - 1 : dirtyMax_[row];
+        for (uint8_t col = c0; col <= c1; ++col)
+        {
+            uint16_t k = charIndex(col, row);
+            if (full || cellChanged(k))
+                fn(k);
+        }
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::tilesToLoad(bool full, uint8_t *need) const
+{
+    memset(need, 0, MinitelTiles::TILE_SET_BYTES);
+    if (!tiles_ || !tiles_->enabled())
+        return 0;
+
+    uint8_t n = 0;
+    forSentCells(full, [&](uint16_t k)
+    {
+        uint8_t id = tileAt(k);
+        if (id == MinitelTiles::NONE || !tiles_->wantsCode(id))
+            return;
+        uint8_t bit = 1u << (id % 8);
+        if (!(need[id / 8] & bit))
+        {
+            need[id / 8] |= bit;
+            ++n;
+        }
+    });
+    return n;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::loadTiles(const uint8_t *need)
+{
+    // Codes still shown after this flush can't be given away
+    uint8_t pinned[MinitelTiles::SLOT_SET_BYTES] = {0};
+    for (uint16_t k = 0; k < NUM_CELLS; ++k)
+    {
+        uint8_t id = tileAt(k);
+        if (id != MinitelTiles::NONE)
+            tiles_->pin(id, pinned);
+    }
+    tiles_->load(need, pinned);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::prepareTiles(bool full)
+{
+    if (!tiles_)
+        return;
+
+    uint8_t need[MinitelTiles::TILE_SET_BYTES];
+    if (tilesToLoad(full, need))
+        loadTiles(need);
+
+    // Each tile drawn counts once as used, most recent last
+    uint8_t used[MinitelTiles::TILE_SET_BYTES] = {0};
+    forSentCells(full, [&](uint16_t k)
+    {
+        uint8_t id = tileAt(k);
+        if (id >= tiles_->size() || (used[id / 8] & (1u << (id % 8))))
+            return;
+        used[id / 8] |= 1u << (id % 8);
+        tiles_->touch(id);
+    });
+}
+
+#endif
+
+// ---------------------- Pixel set helper -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::setSubPixelByChar(uint8_t col, uint8_t row,
+                                   uint8_t subIndex, bool on)
+{
+    if (!inClip(col, row) || subIndex >= 6)
+        return;
+
+    uint16_t k = charIndex(col, row);
+    uint8_t bit = (1u << subIndex);
+    if (!releaseText(k, bit, on))
+        return;
+    markDirty(col, row);
+
+    if (on)
+    {
+        // Stamp the cell with the current drawing color
+        setCell(k, cellMask(k) | bit, drawAttr());
+    }
+    else
+    {
+        // When turning bits off we keep the color as-is, so that if the cell
+        // is still partially ON, the color is preserved.
+        setCell(k, cellMask(k) & ~bit, cellColor(k));
+    }
+}
+
+// ---------------------- Drawing primitives -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawPixel(int x, int y, bool on)
+{
+    Batch batch(*this);
+    if (x < 0 || x >= PIXEL_COLS ||
+        y < 0 || y >= PIXEL_ROWS)
+    {
+        return;
+    }
+
+    uint8_t col = x / 2;
+    uint8_t row = y / 3;
+    uint8_t xInChar = x % 2;
+    uint8_t yInChar = y % 3;
+    uint8_t subIdx = subPixelIndexInChar(xInChar, yInChar);
+
+    setSubPixelByChar(col, row, subIdx, on);
+
+    // Si on est en mode immédiat, on met à jour la cellule à l'écran
+    if (drawMode_ == DrawMode::Immediate)
+    {
+        updateCellOnScreen(col, row);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawLine(int x0, int y0, int x1, int y1, bool on)
+{
+    Batch batch(*this);
+    int dx = abs(x1 - x0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int dy = -abs(y1 - y0);
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx + dy;
+
+    while (true)
+    {
+        drawPixel(x0, y0, on);
+
+        if (x0 == x1 && y0 == y1)
+            break;
+
+        int e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// ---------------------- Span engine -------------------------
+//
+// Fills work one character row (3 pixel rows) at a time: the shape
+// marks its horizontal spans in three 80-bit coverage rows, then each
+// touched cell gets its whole 2x3 mask in a single write (0x3F for full
+// cells), with bit pairs taken straight from the coverage bytes.
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::SpanRow::set(int16_t xl, int16_t xr)
+{
+    if (xl < 0) xl = 0;
+    if (xr >= (int16_t)PIXEL_COLS) xr = PIXEL_COLS - 1;
+    if (xl > xr)
+        return;
+
+    if (xl < xmin) xmin = xl;
+    if (xr > xmax) xmax = xr;
+
+    uint8_t b0 = xl >> 3;
+    uint8_t b1 = xr >> 3;
+    uint8_t m0 = 0xFF >> (xl & 7);
+    uint8_t m1 = 0xFF << (7 - (xr & 7));
+
+    if (b0 == b1)
+    {
+        bits[b0] |= m0 & m1;
+        return;
+    }
+    bits[b0] |= m0;
+    for (uint8_t b = b0 + 1; b < b1; ++b)
+        bits[b] = 0xFF;
+    bits[b1] |= m1;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+template <typename SpanFn>
+void MinitelGfxT<Cols, Rows>::fillRows(int16_t y0, int16_t y1, SpanFn spans, bool on)
+{
+    // Only rows inside the clip can change
+    if (y0 < (int16_t)clipRow0_ * 3) y0 = clipRow0_ * 3;
+    if (y1 > (int16_t)clipRow1_ * 3 + 2) y1 = clipRow1_ * 3 + 2;
+    if (y0 > y1)
+        return;
+
+    for (uint8_t row = y0 / 3; row <= y1 / 3; ++row)
+    {
+        SpanRow sub[3];
+        int16_t xmin = PIXEL_COLS;
+        int16_t xmax = -1;
+
+        for (uint8_t j = 0; j < 3; ++j)
+        {
+            SpanRow &r = sub[j];
+            memset(r.bits, 0, sizeof(r.bits));
+            r.xmin = PIXEL_COLS;
+            r.xmax = -1;
+
+            int16_t y = row * 3 + j;
+            if (y < y0 || y > y1)
+                continue;
+            spans(y, r);
+            if (r.xmin < xmin) xmin = r.xmin;
+            if (r.xmax > xmax) xmax = r.xmax;
+        }
+        if (xmax < xmin)
+            continue;
+
+        for (uint8_t col = xmin >> 1; col <= (xmax >> 1); ++col)
+        {
+            uint8_t shift = 6 - 2 * (col & 3);
+            uint8_t mask = PAIR_TO_MASK[(sub[0].bits[col >> 2] >> shift) & 0x03] |
+                           PAIR_TO_MASK[(sub[1].bits[col >> 2] >> shift) & 0x03] << 2 |
+                           PAIR_TO_MASK[(sub[2].bits[col >> 2] >> shift) & 0x03] << 4;
+            if (mask)
+                applyCellMask(col, row, mask, on);
+        }
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawRect(int x, int y, int w, int h,
+                          bool filled, bool on)
+{
+    Batch batch(*this);
+    if (w <= 0 || h <= 0)
+        return;
+
+    int x2 = x + w - 1;
+    int y2 = y + h - 1;
+
+    fillRows(y, y2, [&](int16_t yy, SpanRow &r)
+    {
+        if (filled || yy == y || yy == y2)
+        {
+            r.set(x, x2);
+        }
+        else
+        {
+            r.set(x, x);
+            r.set(x2, x2);
+        }
+    }, on);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawPolyline(const int16_t *xs, const int16_t *ys,
+                              uint8_t count, uint8_t thickness, bool on)
+{
+    Batch batch(*this);
+    if (!xs || !ys || count == 0)
+        return;
+    if (count == 1)
+    {
+        drawLineThick(xs[0], ys[0], xs[0], ys[0], thickness, on);
+        return;
+    }
+
+    for (uint8_t i = 0; i + 1 < count; ++i)
+    {
+        drawLineThick(xs[i], ys[i], xs[i + 1], ys[i + 1], thickness, on);
+
+        // Round joints, so thick segments do not leave notches
+        if (thickness > 2 && i > 0)
+            drawCircle(xs[i], ys[i], (thickness - 1) / 2, true, 1, on);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawPolygon(const int16_t *xs, const int16_t *ys,
+                             uint8_t count, bool filled,
+                             uint8_t thickness, bool on)
+{
+    Batch batch(*this);
+    if (!xs || !ys || count == 0)
+        return;
+
+    if (filled)
+        fillPolygon(xs, ys, count, on);
+
+    if (!filled || thickness > 1)
+    {
+        drawPolyline(xs, ys, count, thickness, on);
+        if (count > 2)
+        {
+            drawLineThick(xs[count - 1], ys[count - 1], xs[0], ys[0],
+                          thickness, on);
+            if (thickness > 2)
+                drawCircle(xs[0], ys[0], (thickness - 1) / 2, true, 1, on);
+        }
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawTriangle(int x1, int y1,
+                              int x2, int y2,
+                              int x3, int y3,
+                              bool filled, uint8_t thickness, bool on)
+{
+    Batch batch(*this);
+    const int16_t xs[3] = {(int16_t)x1, (int16_t)x2, (int16_t)x3};
+    const int16_t ys[3] = {(int16_t)y1, (int16_t)y2, (int16_t)y3};
+    drawPolygon(xs, ys, 3, filled, thickness, on);
+}
+
+// floor(sqrt(v))
+static uint16_t isqrt32(uint32_t v)
+{
+    uint32_t r = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > v)
+        bit >>= 2;
+    while (bit)
+    {
+        if (v >= r + bit)
+        {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        }
+        else
+        {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)r;
+}
+
+// Half width of a circle of radius r on row dy (-1: row outside).
+// r^2 + r rather than r^2 gives the usual midpoint-circle shape.
+static int16_t circleHalfWidth(int16_t r, int16_t dy)
+{
+    if (r < 0)
+        return -1;
+    int32_t v = (int32_t)r * r + r - (int32_t)dy * dy;
+    return (v < 0) ? -1 : (int16_t)isqrt32((uint32_t)v);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawCircle(int cx, int cy, int radius,
+                            bool filled, uint8_t thickness, bool on)
+{
+    Batch batch(*this);
+    if (radius < 0)
+        return;
+    if (thickness < 1)
+        thickness = 1;
+
+    // Ring between the outer circle and an inner hole (none if filled)
+    int16_t inner = filled ? -1 : (int16_t)(radius - thickness);
+
+    fillRows(cy - radius, cy + radius, [&](int16_t y, SpanRow &r)
+    {
+        int16_t dy = y - cy;
+        int16_t xo = circleHalfWidth(radius, dy);
+        int16_t xi = circleHalfWidth(inner, dy);
+        if (xi < 0)
+        {
+            r.set(cx - xo, cx + xo);
+        }
+        else
+        {
+            r.set(cx - xo, cx - xi - 1);
+            r.set(cx + xi + 1, cx + xo);
+        }
+    }, on);
+}
+
+// num / den rounded to nearest, den > 0
+static int16_t roundDiv(int32_t num, int32_t den)
+{
+    return (int16_t)((num >= 0) ? (num + den / 2) / den
+                                : -((-num + den / 2) / den));
+}
+
+// ceil(v / 256) for Q8 values
+static int16_t ceilQ8(int32_t v)
+{
+    return (v >= 0) ? (int16_t)((v + 255) >> 8) : (int16_t)-((-v) >> 8);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::fillPolygon(const int16_t *xs, const int16_t *ys,
+                             uint8_t count, bool on)
+{
+    if (count < 3)
+        return;
+
+    int16_t ymin = ys[0];
+    int16_t ymax = ys[0];
+    for (uint8_t i = 1; i < count; ++i)
+    {
+        if (ys[i] < ymin) ymin = ys[i];
+        if (ys[i] > ymax) ymax = ys[i];
+    }
+
+    fillRows(ymin, ymax, [&](int16_t y, SpanRow &r)
+    {
+        // Even-odd crossings of row y (vertices are pixel centres, as
+        // for drawLine()), in Q8, sorted
+        int32_t xq[MGFX_POLY_MAX_CROSSINGS];
+        uint8_t n = 0;
+
+        for (uint8_t i = 0, j = count - 1; i < count && n < MGFX_POLY_MAX_CROSSINGS; j = i++)
+        {
+            int32_t yi = ys[i];
+            int32_t yj = ys[j];
+            if ((yi > y) == (yj > y))
+                continue;
+
+            int32_t x = (int32_t)xs[i] * 256 +
+                        (y - yi) * (xs[j] - xs[i]) * 256 / (yj - yi);
+
+            uint8_t k = n++;
+            for (; k > 0 && xq[k - 1] > x; --k)
+                xq[k] = xq[k - 1];
+            xq[k] = x;
+        }
+
+        // Pixels in [xq[k], xq[k + 1]]
+        for (uint8_t k = 0; k + 1 < n; k += 2)
+            r.set(ceilQ8(xq[k]), (int16_t)(xq[k + 1] >> 8));
+    }, on);
+
+    // Edge pixels, so the fill covers the same outline as drawPolygon()
+    for (uint8_t i = 0, j = count - 1; i < count; j = i++)
+        drawLine(xs[j], ys[j], xs[i], ys[i], on);
+}
+
+// ---------------------- mask -> G1 code -------------------------
+
+namespace
+{
+constexpr uint8_t g1Code(uint8_t mask)
+{
+    return mask == 0      ? 0x20                             // all background -> 2/0
+         : mask == 0x3F   ? 0x5F                             // all foreground -> 5/15 (STUM trap)
+         : mask < 0x20    ? (uint8_t)(0x20 + mask)           // 1..31 -> 0x21..0x3F
+                          : (uint8_t)(0x60 + (mask - 0x20)); // 32..62 -> 0x60..0x7E
+}
+}
+
+#define MGFX_G1_4(m) g1Code(m), g1Code(m + 1), g1Code(m + 2), g1Code(m + 3)
+#define MGFX_G1_16(m) MGFX_G1_4(m), MGFX_G1_4(m + 4), MGFX_G1_4(m + 8), MGFX_G1_4(m + 12)
+
+// Built by the compiler from g1Code(): one read per cell, no branches
+static const uint8_t MASK_TO_G1[64] PROGMEM = {
+    MGFX_G1_16(0), MGFX_G1_16(16), MGFX_G1_16(32), MGFX_G1_16(48)};
+
+#undef MGFX_G1_16
+#undef MGFX_G1_4
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::maskToG1(uint8_t mask) const
+{
+    return pgm_read_byte(&MASK_TO_G1[mask & 0x3F]);
+}
+
+// ---------------------- Cell encoder -------------------------
+//
+// Accumulates consecutive identical glyphs into runs and emits each run
+// as [SI|SO] [ESC attributes] code [REP n], the code going through
+// Minitel::writeRepeated(). With dev == nullptr nothing is sent and
+// only the byte count is tracked, which lets flush() price a path
+// before committing to it.
+
+namespace
+{
+// Terminal attributes as the encoder sees them (0xFF: unknown)
+struct Attrs
+{
+    uint8_t g1; // charset, 1 = G1
+    uint8_t fg;
+    uint8_t flash;
+    uint8_t negative;
+    uint8_t size; // Minitel::CharSize
+    uint8_t bg;   // pending background, taken by the next delimiter
+    uint8_t drcs; // G0 is the DRCS set (G1 does not care)
+};
+
+bool sameAttrs(const Attrs &a, const Attrs &b)
+{
+    return a.g1 == b.g1 && a.fg == b.fg && a.flash == b.flash &&
+           a.negative == b.negative && a.size == b.size && a.bg == b.bg &&
+           a.drcs == b.drcs;
+}
+
+Attrs termAttrs(const Minitel::TermState &t)
+{
+    Attrs a;
+    a.g1 = (t.charset == Minitel::CharSet::G1_GRAPHIC) ? 1 : 0;
+    a.drcs = t.drcs ? 1 : 0;
+    if (t.attrsKnown)
+    {
+        a.fg = static_cast<uint8_t>(t.fg);
+        a.flash = t.flash;
+        a.negative = t.negative;
+        a.size = static_cast<uint8_t>(t.size);
+        a.bg = static_cast<uint8_t>(t.bg);
+    }
+    else
+    {
+        a.fg = a.flash = a.negative = a.size = a.bg = 0xFF;
+    }
+    return a;
+}
+
+// What US row col leaves behind
+const Attrs US_ATTRS = {0, static_cast<uint8_t>(Minitel::Color::White), 0, 0, 0,
+                        static_cast<uint8_t>(Minitel::Color::Black), 0};
+
+// Same, from `from`: the designated G0 set stays
+Attrs afterUS(const Attrs &from)
+{
+    Attrs a = US_ATTRS;
+    a.drcs = from.drcs;
+    return a;
+}
+}
+
+template <uint8_t Cols, uint8_t Rows>
+struct MinitelGfxT<Cols, Rows>::Glyph
+{
+    uint8_t code;
+    bool blank; // background only: any charset and colour will do
+    bool anyBg; // not a delimiter: shows its zone's background
+    Attrs a;    // what the code needs
+};
+
+template <uint8_t Cols, uint8_t Rows>
+struct MinitelGfxT<Cols, Rows>::CellEncoder
+{
+    Minitel *dev;   // nullptr: count bytes only
+    Attrs term;     // terminal attributes before the pending run
+    Glyph run;      // pending run
+    uint8_t len;
+    uint16_t bytes; // bytes committed so far
+    uint16_t cursor; // cell the pending run starts on (NUM_CELLS: unknown)
+
+    // SI / SO (1 byte) and attribute escapes (2 bytes each) before g
+    static uint8_t switchCost(const Attrs &from, const Glyph &g)
+    {
+        const Attrs &a = g.a;
+        uint8_t cost = (a.g1 != from.g1) ? 1 : 0;
+        cost += (a.fg != from.fg) ? 2 : 0;
+        cost += (a.flash != from.flash) ? 2 : 0;
+        cost += (a.bg != from.bg) ? 2 : 0;
+        if (!a.g1)
+        {
+            cost += (a.negative != from.negative) ? 2 : 0;
+            cost += (a.size != from.size) ? 2 : 0;
+            // ESC 2/8 2/0 4/2 to the DRCS set, ESC 2/8 4/2 back
+            if (a.drcs != from.drcs)
+                cost += a.drcs ? 4 : 3;
+        }
+        return cost;
+    }
+
+    static Attrs after(const Attrs &from, const Glyph &g)
+    {
+        Attrs a = g.a;
+        if (a.g1 && from.g1)
+        {
+            // No SO sent: size and polarity stay as they were
+            a.negative = from.negative;
+            a.size = from.size;
+        }
+        if (a.g1)
+            a.drcs = from.drcs;
+        return a;
+    }
+
+    uint8_t width() const { return (!run.a.g1 && (run.a.size & 2)) ? 2 : 1; }
+    uint16_t pendingCells() const { return (uint16_t)len * width(); }
+
+    uint16_t pendingCost() const
+    {
+        if (len == 0)
+            return 0;
+        return switchCost(term, run) + Minitel::repeatCost(len);
+    }
+
+    uint16_t total() const { return bytes + pendingCost(); }
+
+    // Where the cursor will be once the pending run is out. In page
+    // mode each char moves it right and col 40 wraps to col 1 of the
+    // next row, i.e. the next cell in row-major order. Past the last
+    // cell it wraps to the top: unknown.
+    uint16_t cursorAfter() const
+    {
+        if (cursor >= NUM_CELLS)
+            return NUM_CELLS;
+        uint16_t k = cursor + pendingCells();
+        // Past the last column of a narrower canvas: off the canvas
+        if (!fullWidth() && k / CELL_COLS != cursor / CELL_COLS)
+            return NUM_CELLS;
+        return (k < NUM_CELLS) ? k : NUM_CELLS;
+    }
+
+    Attrs state() const { return (len > 0) ? after(term, run) : term; }
+
+    void add(Glyph g)
+    {
+        Attrs s = state();
+        if (g.anyBg)
+        {
+            g.a.bg = s.bg;
+            g.anyBg = false;
+        }
+        if (g.blank)
+        {
+            // Keep the current foreground; a G0 space also needs normal
+            // size and polarity, else SO (which resets both) is cheapest
+            uint8_t bg = g.a.bg;
+            g.a = s;
+            g.a.bg = bg;
+            if (!(s.g1 == 0 && s.size == 0 && s.negative == 0))
+            {
+                g.a.g1 = 1;
+                g.a.negative = 0;
+                g.a.size = 0;
+            }
+            g.blank = false;
+        }
+
+        if (len > 0 && g.code == run.code && sameAttrs(g.a, run.a))
+        {
+            ++len;
+            return;
+        }
+        close();
+        run = g;
+        len = 1;
+    }
+
+    void close()
+    {
+        if (len == 0)
+            return;
+        bytes += pendingCost();
+        if (dev)
+            emit();
+        cursor = cursorAfter();
+        term = after(term, run);
+        len = 0;
+    }
+
+    void emit() const
+    {
+        const Attrs &a = run.a;
+        if (a.g1)
+        {
+            if (a.fg != term.fg)
+                dev->setCharColor(static_cast<Minitel::Color>(a.fg));
+            if (a.flash != term.flash)
+                dev->setFlash(a.flash);
+            if (a.bg != term.bg)
+                dev->setBgColor(static_cast<Minitel::Color>(a.bg));
+            dev->beginSemiGraphics();
+        }
+        else
+        {
+            // Polarity and size only exist in G0: switch first
+            dev->endSemiGraphics();
+            dev->selectDrcs(a.drcs);
+            if (a.fg != term.fg)
+                dev->setCharColor(static_cast<Minitel::Color>(a.fg));
+            if (a.flash != term.flash)
+                dev->setFlash(a.flash);
+            if (a.bg != term.bg)
+                dev->setBgColor(static_cast<Minitel::Color>(a.bg));
+            if (a.negative != term.negative)
+                dev->setPolarity(a.negative);
+            if (a.size != term.size)
+            {
+                switch (static_cast<Minitel::CharSize>(a.size))
+                {
+                case Minitel::CharSize::DoubleHeight: dev->setDoubleHeight(true); break;
+                case Minitel::CharSize::DoubleWidth:  dev->setDoubleWidth(true); break;
+                case Minitel::CharSize::DoubleSize:   dev->setDoubleSize(true); break;
+                default:                              dev->setSizeNormal(); break;
+                }
+            }
+        }
+        dev->writeRepeated(run.code, len);
+    }
+};
+
+template <uint8_t Cols, uint8_t Rows>
+typename MinitelGfxT<Cols, Rows>::Glyph MinitelGfxT<Cols, Rows>::glyphAt(uint16_t k) const
+{
+    uint8_t mask = cellMask(k);
+    uint8_t color = cellColor(k);
+
+    Glyph g = {0x20, mask == 0, false, US_ATTRS};
+    g.a.bg = color >> ATTR_BG_SHIFT;
+#if MGFX_TEXT_PLANE
+    uint8_t id = tileAt(k);
+    if (id != MinitelTiles::NONE)
+    {
+        // Tile: its DRCS code, else the nearest mosaic
+        uint8_t code = tiles_ ? tiles_->code(id) : 0;
+        if (code)
+        {
+            g.code = code;
+            g.anyBg = true;
+            g.a.fg = color & 0x07;
+            g.a.flash = (color & ATTR_FLASH) ? 1 : 0;
+            g.a.negative = (color & ATTR_NEGATIVE) ? 1 : 0;
+            g.a.drcs = 1;
+            return g;
+        }
+        // A mosaic is a delimiter: keep the zone's background
+        mask = tiles_ ? tiles_->mosaic(id) : 0;
+        g.blank = (mask == 0);
+        g.a.bg = shownBg(k);
+        color &= 0x07;
+    }
+#endif
+    if (mask & CELL_TEXT)
+    {
+        g.code = mask & 0x7F;
+        g.anyBg = (g.code != ' ');
+        g.a.fg = color & 0x07;
+        g.a.flash = (color & ATTR_FLASH) ? 1 : 0;
+        g.a.negative = (color & ATTR_NEGATIVE) ? 1 : 0;
+        g.a.size = textSize(k);
+    }
+    else if (mask != 0)
+    {
+        g.code = maskToG1(mask);
+        g.a.g1 = 1;
+        g.a.fg = color & 0x07;
+    }
+    return g;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::flush(FlushMode mode)
+{
+    const bool full = (mode == FlushMode::FullRedraw);
+
+    // Writing the last cell would scroll the screen
+    dev_.setRollMode(false);
+
+    // Nothing drawn since the last flush: nothing to compare or send
+    if (!full && dirtyRows_ == 0)
+        return;
+
+    // Profilers' timeline: the queue ahead, then what this frame adds
+    dev_.trace(Minitel::Trace::FlushBegin, dev_.txQueued());
+    uint32_t queued = dev_.stats().txTotal();
+
+#if MGFX_TEXT_PLANE
+    prepareTiles(full);
+#endif
+
+    uint16_t changed = 0;
+    encodeCells(full, &dev_, &changed);
+    if (changed)
+        dev_.countCells(changed, true);
+
+    // Sync the shadows, only over what may have changed
+    if (full)
+    {
+        syncCells(0, NUM_CELLS);
+    }
+    else
+    {
+        for (uint8_t row = 0; row < CELL_ROWS; ++row)
+        {
+            if (!(dirtyRows_ & (1UL << row)))
+                continue;
+            uint16_t k = charIndex(dirtyMin_[row], row);
+            uint8_t n = dirtyMax_[row] - dirtyMin_[row] + 1;
+            syncCells(k, n);
+        }
+    }
+    clearDirty();
+    streamArmed_ = false;
+    dev_.trace(Minitel::Trace::FlushEnd,
+               (uint16_t)(dev_.stats().txTotal() - queued));
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint16_t MinitelGfxT<Cols, Rows>::flushCost(FlushMode mode) const
+{
+    const bool full = (mode == FlushMode::FullRedraw);
+    if (!full && dirtyRows_ == 0)
+        return 0;
+    uint16_t cost = encodeCells(full, nullptr);
+    if (dev_.termState().roll)
+        cost += 4; // roll mode off first
+
+#if MGFX_TEXT_PLANE
+    // Uploads, as if each tile found a code
+    uint8_t need[MinitelTiles::TILE_SET_BYTES];
+    if (uint8_t n = tilesToLoad(full, need))
+        cost += MinitelTiles::LOAD_HEADER_BYTES +
+                n * MinitelTiles::LOAD_TILE_BYTES;
+#endif
+    return cost;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::flushIfRoom(FlushMode mode, uint16_t *bytes)
+{
+    uint16_t cost = flushCost(mode);
+    if (bytes)
+        *bytes = cost;
+
+    // A diff larger than the allowance goes once the queue is empty
+    uint16_t queued = dev_.txQueued();
+    if (queued > 0 &&
+        (cost > dev_.txFree() || (uint32_t)queued + cost > maxBacklog_))
+        return false;
+
+    flush(mode);
+    return true;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint16_t MinitelGfxT<Cols, Rows>::encodeCells(bool full, Minitel *out,
+                                 uint16_t *changed) const
+{
+    uint16_t count = 0;
+    CellEncoder enc = {out, termAttrs(dev_.termState()), Glyph(), 0, 0,
+                       cursorCell()};
+
+    // Queue one cell on the encoder. Runs never span two rows, and the
+    // parts of a larger character are drawn by its owner.
+    auto emitCell = [&](CellEncoder &e, uint16_t k)
+    {
+        if (k % CELL_COLS == 0)
+            e.close();
+        if (!isTextPart(k))
+            e.add(glyphAt(k));
+    };
+
+    // The whole screen is one row-major stream of cells: the cursor wraps
+    // from col 40 to col 1 of the next row by itself. Between two changed
+    // cells we either re-send the unchanged ones in between or move.
+    auto visit = [&](uint16_t k)
+    {
+        if (isTextPart(k) || (!full && !cellChanged(k)))
+            return;
+
+        // Where the cursor will be once the pending run is out
+        uint16_t at = enc.cursorAfter();
+        if (at != k)
+        {
+            // Price a jump: close the pending run, move, draw cell k
+            bool absolute;
+            uint16_t cost = jumpCost(enc, at, k, absolute);
+
+            // Price a bridge: re-send cells at..k-1, bail out once dearer.
+            // Parts of a larger character can only be crossed along with
+            // their owner, i.e. the right half of one sent in the bridge.
+            bool bridge = (at < k) && (fullWidth() || at / CELL_COLS == k / CELL_COLS);
+            if (bridge)
+            {
+                CellEncoder span = enc;
+                span.dev = nullptr;
+                for (uint16_t i = at; i <= k && bridge; ++i)
+                {
+                    if (isTextPart(i) &&
+                        (i == at || cellMask(i) != (CELL_TEXT | TEXT_RIGHT)))
+                    {
+                        bridge = false;
+                        break;
+                    }
+                    emitCell(span, i);
+                    bridge = span.total() < cost;
+                }
+            }
+
+            if (bridge)
+            {
+                for (uint16_t i = at; i < k; ++i)
+                    emitCell(enc, i);
+            }
+            else
+            {
+                jumpTo(enc, k, absolute);
+            }
+        }
+
+        emitCell(enc, k);
+        ++count;
+    };
+
+    // Only dirty spans can hold changed cells, in row-major order
+    for (uint8_t row = 0; row < CELL_ROWS; ++row)
+    {
+        if (!full && !(dirtyRows_ & (1UL << row)))
+            continue;
+        uint8_t c0 = full ? 0 : dirtyMin_[row];
+        uint8_t c1 = full ? CELL_COLS - 1 : dirtyMax_[row];
+        for (uint8_t col = c0; col <= c1; ++col)
+            visit(charIndex(col, row));
+    }
+
+    enc.close();
+
+    // Leave the terminal in G0, the standard one, for whatever prints next
+    if (count && enc.term.g1)
+    {
+        ++enc.bytes;
+        if (out)
+            out->endSemiGraphics();
+    }
+    if (enc.term.drcs)
+    {
+        enc.bytes += 3;
+        if (out)
+            out->selectDrcs(false);
+    }
+    if (changed)
+        *changed = count;
+    return enc.bytes;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint16_t MinitelGfxT<Cols, Rows>::cursorCell() const
+{
+    // Row 00 is not part of the grid
+    const Minitel::TermState &t = dev_.termState();
+    if (!t.cursorKnown || t.row <= originRow_ || t.row > originRow_ + CELL_ROWS ||
+        t.col <= originCol_ || t.col > originCol_ + CELL_COLS)
+        return NUM_CELLS;
+
+    return charIndex(t.col - 1 - originCol_, t.row - 1 - originRow_);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::relativeMoveCost(uint16_t from, uint8_t row, uint8_t col) const
+{
+    // LF/VT for rows, then HT/BS or CR + HT for columns: 1 byte each
+    uint8_t fromRow = screenRow(from);
+    uint8_t fromCol = screenCol(from);
+    uint8_t dr = (row > fromRow) ? row - fromRow : fromRow - row;
+    uint8_t dc = (col > fromCol) ? col - fromCol : fromCol - col;
+    uint8_t viaCR = 1 + (col - 1);
+    return dr + (viaCR < dc ? viaCR : dc);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint16_t MinitelGfxT<Cols, Rows>::jumpCost(const CellEncoder &enc, uint16_t from,
+                              uint16_t k, bool &absolute) const
+{
+    uint8_t row = screenRow(k);
+    uint8_t col = screenCol(k);
+    Glyph g = glyphAt(k);
+
+    CellEncoder jump = enc;
+    jump.dev = nullptr;
+    jump.close();
+
+    // Absolute move: US + row + col, which also resets attributes, so
+    // we may pay SO and a colour change again
+    CellEncoder us = jump;
+    us.term = afterUS(jump.term);
+    us.add(g);
+    uint16_t costUS = 3 + us.total();
+
+    if (from < NUM_CELLS)
+    {
+        // Relative moves keep the attributes
+        jump.add(g);
+        uint16_t costRel = relativeMoveCost(from, row, col) + jump.total();
+        if (costRel <= costUS)
+        {
+            absolute = false;
+            return costRel;
+        }
+    }
+
+    absolute = true;
+    return costUS;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::jumpTo(CellEncoder &enc, uint16_t k, bool absolute) const
+{
+    enc.close();
+
+    uint8_t row = screenRow(k);
+    uint8_t col = screenCol(k);
+
+    if (absolute)
+    {
+        // US + row/col, resets attributes
+        enc.bytes += 3;
+        enc.term = afterUS(enc.term);
+        if (enc.dev)
+            enc.dev->setCursor(row, col);
+    }
+    else
+    {
+        // Relative moves only, they keep the attributes
+        enc.bytes += relativeMoveCost(enc.cursor, row, col);
+        if (enc.dev)
+        {
+            // Vertical first. The terminal state shadow follows every
+            // byte we send.
+            Minitel &dev = *enc.dev;
+            const Minitel::TermState &t = dev.termState();
+            while (t.row < row)
+                dev.writeRaw(0x0A); // LF: down
+            while (t.row > row)
+                dev.writeRaw(0x0B); // VT: up
+
+            // Then horizontal, possibly via CR (col 1)
+            uint8_t dc = (col > t.col) ? col - t.col : t.col - col;
+            if (1 + (col - 1) < dc)
+                dev.writeRaw(0x0D); // CR: col 1
+            while (t.col < col)
+                dev.writeRaw(0x09); // HT: right
+            while (t.col > col)
+                dev.writeRaw(0x08); // BS: left
+        }
+    }
+
+    enc.cursor = k;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::updateCellOnScreen(uint8_t col, uint8_t row)
+{
+    if (drawMode_ != DrawMode::Immediate)
+        return;
+    if (col >= CELL_COLS || row >= CELL_ROWS)
+        return;
+
+    uint16_t k = charIndex(col, row);
+
+    // Si pas de changement vs dernier flush / update, on ne fait rien
+    if (!cellChanged(k))
+        return;
+
+    // A part of a larger character goes out with its owner
+    k = textOwner(k);
+
+    CellEncoder enc = {&dev_, termAttrs(dev_.termState()), Glyph(), 0, 0,
+                       cursorCell()};
+
+    // Chemin de curseur "smart" (relatif ou US)
+    uint16_t at = enc.cursor;
+    if (at != k)
+    {
+        bool absolute;
+        jumpCost(enc, at, k, absolute);
+        jumpTo(enc, k, absolute);
+    }
+
+    enc.add(glyphAt(k));
+    enc.close();
+    dev_.selectDrcs(false);
+    dev_.setRollMode(false);
+    dev_.countCells(1, false);
+
+    uint16_t cells[4];
+    uint8_t n = textGroup(k, cells);
+    for (uint8_t i = 0; i < n; ++i)
+        syncCells(cells[i], 1);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::drawLineThick(int x0, int y0, int x1, int y1,
+                               uint8_t thickness, bool on)
+{
+    if (thickness <= 1)
+    {
+        drawLine(x0, y0, x1, y1, on);
+        return;
+    }
+
+    int32_t dx = x1 - x0;
+    int32_t dy = y1 - y0;
+    int32_t len = isqrt32((uint32_t)(dx * dx + dy * dy));
+
+    // Degenerate segment: a thickness x thickness square
+    if (len == 0)
+    {
+        drawRect(x0 - (thickness - 1) / 2, y0 - (thickness - 1) / 2,
+                 thickness, thickness, true, on);
+        return;
+    }
+
+    // Quad around the segment: offsets a and b along the unit normal
+    // (a + b + 1 = thickness, counting the edge pixels), rounded
+    int32_t a = (thickness - 1) / 2;
+    int32_t b = (thickness - 1) - a;
+    int16_t ax = roundDiv(-dy * a, len);
+    int16_t ay = roundDiv( dx * a, len);
+    int16_t bx = roundDiv( dy * b, len);
+    int16_t by = roundDiv(-dx * b, len);
+
+    const int16_t xs[4] = {(int16_t)(x0 + ax), (int16_t)(x1 + ax),
+                           (int16_t)(x1 + bx), (int16_t)(x0 + bx)};
+    const int16_t ys[4] = {(int16_t)(y0 + ay), (int16_t)(y1 + ay),
+                           (int16_t)(y1 + by), (int16_t)(y0 + by)};
+    fillPolygon(xs, ys, 4, on);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteInit(Sprite &spr,
+                            const uint8_t *frames,
+                            uint8_t width,
+                            uint8_t height,
+                            uint8_t frameCount)
+{
+    spriteInit(spr, frames, width, height, frameCount, SpriteFormat::Bytes);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteInit(Sprite &spr,
+                            const uint8_t *frames,
+                            uint8_t width,
+                            uint8_t height,
+                            uint8_t frameCount,
+                            SpriteFormat format)
+{
+    spr.frames = frames;
+    spr.format = format;
+    spr.width = width;
+    spr.height = height;
+    spr.frameCount = frameCount;
+
+    spr.x = spr.y = 0;
+    spr.prevX = spr.prevY = 0;
+    spr.frame = spr.prevFrame = 0;
+
+    spr.angleDeg = 0;
+    spr.prevAngleDeg = 0;
+
+spr.scale = spr.prevScale = 1;
+spr.flipX = spr.prevFlipX = false;
+spr.flipY = spr.prevFlipY = false;
+
+    spr.visible = true;
+    spr.firstDraw = true;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteSetPosition(Sprite &spr, int16_t x, int16_t y)
+{
+    spr.x = x;
+    spr.y = y;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteSetFrame(Sprite &spr, uint8_t frame)
+{
+    if (spr.frameCount == 0)
+    {
+        spr.frame = 0;
+        return;
+    }
+    if (frame >= spr.frameCount)
+    {
+        frame = spr.frameCount - 1;
+    }
+    spr.frame = frame;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteNextFrame(Sprite &spr)
+{
+    if (spr.frameCount == 0)
+        return;
+    spr.frame = (spr.frame + 1) % spr.frameCount;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteShow(Sprite &spr, bool visible)
+{
+    spr.visible = visible;
+}
+
+// ---------------------- Sprite frame access -------------------------
+
+static bool spritePacked(const MinitelGfxBase::Sprite &spr)
+{
+    return spr.format == MinitelGfxBase::SpriteFormat::Packed ||
+           spr.format == MinitelGfxBase::SpriteFormat::PackedProgmem;
+}
+
+// Bytes per source row
+static uint8_t spriteStride(const MinitelGfxBase::Sprite &spr)
+{
+    return spritePacked(spr) ? (uint8_t)((spr.width + 7) / 8) : spr.width;
+}
+
+// Read one frame byte from RAM or flash
+static inline uint8_t spriteByte(const MinitelGfxBase::Sprite &spr, const uint8_t *p)
+{
+    if (spr.format == MinitelGfxBase::SpriteFormat::BytesProgmem ||
+        spr.format == MinitelGfxBase::SpriteFormat::PackedProgmem)
+    {
+        return pgm_read_byte(p);
+    }
+    return *p;
+}
+
+// Source pixel (sx, sy) of a frame starting at base
+static inline bool spritePixel(const MinitelGfxBase::Sprite &spr, const uint8_t *base,
+                               int16_t sx, int16_t sy)
+{
+    if (spritePacked(spr))
+    {
+        uint8_t b = spriteByte(spr, base + sy * spriteStride(spr) + (sx >> 3));
+        return (b & (0x80 >> (sx & 7))) != 0;
+    }
+    return spriteByte(spr, base + sy * spr.width + sx) != 0;
+}
+
+// Floor division, also for negative sprite coordinates
+static int16_t floorDiv(int16_t a, int16_t b)
+{
+    return (a >= 0) ? a / b : (int16_t)(-((-a + b - 1) / b));
+}
+
+// ---------------------- Fixed-point rotation -------------------------
+
+// sin(0..90 deg) in Q14
+static const int16_t SIN_Q14[91] PROGMEM = {
+    0, 286, 572, 857, 1143, 1428, 1713, 1997, 2280, 2563,
+    2845, 3126, 3406, 3686, 3964, 4240, 4516, 4790, 5063, 5334,
+    5604, 5872, 6138, 6402, 6664, 6924, 7182, 7438, 7692, 7943,
+    8192, 8438, 8682, 8923, 9162, 9397, 9630, 9860, 10087, 10311,
+    10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+    12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+    14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+    15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+    16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+    16384};
+
+// sin of a normalized angle (0..359), Q14
+static int16_t sinQ14(int16_t a)
+{
+    if (a < 90)  return  (int16_t)pgm_read_word(&SIN_Q14[a]);
+    if (a < 180) return  (int16_t)pgm_read_word(&SIN_Q14[180 - a]);
+    if (a < 270) return -(int16_t)pgm_read_word(&SIN_Q14[a - 180]);
+    return -(int16_t)pgm_read_word(&SIN_Q14[360 - a]);
+}
+
+static int16_t cosQ14(int16_t a)
+{
+    return sinQ14(a >= 270 ? a - 270 : a + 90);
+}
+
+// Pixel box that a outW x outH sprite rotated by (ca, sa) may touch,
+// relative to its top-left corner (inclusive, with a 1 pixel margin).
+static void rotatedExtent(int16_t outW, int16_t outH,
+                          int16_t ca, int16_t sa,
+                          int16_t &x0, int16_t &y0,
+                          int16_t &x1, int16_t &y1)
+{
+    int32_t aca = (ca < 0) ? -ca : ca;
+    int32_t asa = (sa < 0) ? -sa : sa;
+
+    // Half extents, in half pixels, rounded up
+    int16_t hw = (int16_t)((aca * outW + asa * outH + 16383) >> 14);
+    int16_t hh = (int16_t)((asa * outW + aca * outH + 16383) >> 14);
+
+    x0 = (int16_t)((outW - hw) >> 1) - 1;
+    x1 = (int16_t)((outW + hw) >> 1) + 1;
+    y0 = (int16_t)((outH - hh) >> 1) - 1;
+    y1 = (int16_t)((outH + hh) >> 1) + 1;
+}
+
+// Inverse-map every pixel of [x0..x1] x [y0..y1] (relative to the
+// sprite's top-left corner) into the source frame and call plot(x, y)
+// for the lit ones. Rotation is around the centre of the scaled box.
+// Each row is a DDA: stepping x adds constants to the Q15 source coords.
+template <typename Plot>
+static void rotateScan(const MinitelGfxBase::Sprite &spr, const uint8_t *base,
+                       uint8_t scale, int16_t ca, int16_t sa,
+                       bool flipX, bool flipY,
+                       int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                       Plot plot)
+{
+    const int16_t outW = (int16_t)spr.width  * scale;
+    const int16_t outH = (int16_t)spr.height * scale;
+    const int32_t limW = (int32_t)outW << 15;
+    const int32_t limH = (int32_t)outH << 15;
+
+    // dx, dy in half pixels from the centre: 2 * x - outW
+    const int16_t dx0 = 2 * x0 - outW;
+
+    for (int16_t y = y0; y <= y1; ++y) {
+        int16_t dy = 2 * y - outH;
+
+        // Source coordinates (output space, Q15) at x0, and per-x steps
+        int32_t ox = (int32_t)ca * dx0 + (int32_t)sa * dy + ((int32_t)outW << 14);
+        int32_t oy = -(int32_t)sa * dx0 + (int32_t)ca * dy + ((int32_t)outH << 14);
+
+        for (int16_t x = x0; x <= x1; ++x, ox += 2 * (int32_t)ca,
+                                           oy -= 2 * (int32_t)sa) {
+            if (ox < 0 || oy < 0 || ox >= limW || oy >= limH) continue;
+
+            int16_t sx = (int16_t)(ox >> 15);
+            int16_t sy = (int16_t)(oy >> 15);
+            if (scale > 1) {
+                sx /= scale;
+                sy /= scale;
+            }
+            if (flipX) sx = (int16_t)spr.width  - 1 - sx;
+            if (flipY) sy = (int16_t)spr.height - 1 - sy;
+
+            if (spritePixel(spr, base, sx, sy))
+                plot(x, y);
+        }
+    }
+}
+
+// Side of the square holding any rotation of a w x h frame
+static uint8_t rotationSide(uint8_t w, uint8_t h)
+{
+    uint16_t d2 = (uint16_t)w * w + (uint16_t)h * h;
+    uint8_t d = 1;
+    while ((uint16_t)d * d < d2)
+        ++d;
+    return d + 2;
+}
+
+// Top-left of that square, relative to the frame's top-left
+static int16_t rotationOrigin(uint8_t size, uint8_t side)
+{
+    return floorDiv((int16_t)size - side, 2);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::applyCellMask(uint8_t col, uint8_t row, uint8_t mask, bool on)
+{
+    if (!inClip(col, row))
+        return;
+
+    uint16_t k = charIndex(col, row);
+    if (!releaseText(k, mask, on))
+        return;
+    markDirty(col, row);
+
+    if (on)
+        setCell(k, cellMask(k) | mask, drawAttr());
+    else
+        setCell(k, cellMask(k) & ~mask, cellColor(k));
+
+    if (drawMode_ == DrawMode::Immediate)
+    {
+        updateCellOnScreen(col, row);
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteBlitCells(const Sprite& spr,
+                                 const uint8_t* base,
+                                 int16_t dstX,
+                                 int16_t dstY,
+                                 bool flipX,
+                                 bool flipY,
+                                 bool on)
+{
+    const int16_t w = spr.width;
+    const int16_t h = spr.height;
+    const uint8_t stride = spriteStride(spr);
+    const bool packed = spritePacked(spr);
+
+    // Cells covered by the sprite, clipped
+    int16_t c0 = floorDiv(dstX, 2);
+    int16_t c1 = floorDiv(dstX + w - 1, 2);
+    int16_t r0 = floorDiv(dstY, 3);
+    int16_t r1 = floorDiv(dstY + h - 1, 3);
+    if (c0 < clipCol0_) c0 = clipCol0_;
+    if (r0 < clipRow0_) r0 = clipRow0_;
+    if (c1 > clipCol1_) c1 = clipCol1_;
+    if (r1 > clipRow1_) r1 = clipRow1_;
+
+    // Even x on packed data: both sub-pixels of a cell are one bit pair
+    // of a single source byte. Otherwise, the generic shifted variant
+    // gathers the 6 sub-pixels one by one.
+    const bool pairs = packed && !flipX && (dstX & 1) == 0;
+
+    for (int16_t row = r0; row <= r1; ++row) {
+        // Source rows behind the 3 sub-rows of this cell row
+        const uint8_t* src[3];
+        for (uint8_t j = 0; j < 3; ++j) {
+            int16_t sy = row * 3 + j - dstY;
+            if (sy < 0 || sy >= h) {
+                src[j] = nullptr;
+                continue;
+            }
+            if (flipY) sy = h - 1 - sy;
+            src[j] = base + sy * stride;
+        }
+
+        for (int16_t col = c0; col <= c1; ++col) {
+            int16_t sx0 = col * 2 - dstX; // source x of the left sub-pixel
+            uint8_t mask = 0;
+
+            for (uint8_t j = 0; j < 3; ++j) {
+                if (!src[j]) continue;
+
+                if (pairs) {
+                    uint8_t b = spriteByte(spr, src[j] + (sx0 >> 3));
+                    uint8_t pair = (b >> (6 - (sx0 & 6))) & 0x03;
+                    if (sx0 + 1 >= w) pair &= 0x02; // ignore row padding
+                    mask |= PAIR_TO_MASK[pair] << (2 * j);
+                    continue;
+                }
+
+                for (uint8_t i = 0; i < 2; ++i) {
+                    int16_t sx = sx0 + i;
+                    if (sx < 0 || sx >= w) continue;
+                    if (flipX) sx = w - 1 - sx;
+
+                    bool v = packed
+                        ? (spriteByte(spr, src[j] + (sx >> 3)) & (0x80 >> (sx & 7))) != 0
+                        : spriteByte(spr, src[j] + sx) != 0;
+                    if (v) mask |= 1 << (2 * j + i);
+                }
+            }
+
+            if (mask) applyCellMask(col, row, mask, on);
+        }
+    }
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteBlitFrame(const Sprite& spr,
+                                 int16_t dstX,
+                                 int16_t dstY,
+                                 uint8_t frameIndex,
+                                 int16_t angleDeg,
+                                 uint8_t scale,
+                                 bool flipX,
+                                 bool flipY,
+                                 bool on)
+{
+    if (!spr.frames) return;
+    if (spr.width == 0 || spr.height == 0) return;
+    if (spr.frameCount == 0) return;
+
+    if (scale < 1) scale = 1;
+    if (scale > 6) scale = 6;
+
+    frameIndex %= spr.frameCount;
+
+    const uint8_t stride = spriteStride(spr);
+    const bool packed = spritePacked(spr);
+    const uint8_t* base = spr.frames +
+                          (uint32_t)frameIndex * stride * spr.height;
+
+    angleDeg = normalizeAngleDeg(angleDeg);
+
+    const int16_t outW = (int16_t)spr.width  * (int16_t)scale;
+    const int16_t outH = (int16_t)spr.height * (int16_t)scale;
+
+    // Fastest path: no rotation, no scaling. Build each cell's 6-bit
+    // mask and apply it in one go.
+    if (angleDeg == 0 && scale == 1) {
+        spriteBlitCells(spr, base, dstX, dstY, flipX, flipY, on);
+        return;
+    }
+
+    // Fast path: no rotation. Walk the source one byte at a time (8
+    // pixels when packed, empty bytes skipped) and write sub-pixels
+    // straight into the cell masks.
+    if (angleDeg == 0) {
+        for (int16_t oy = 0; oy < outH; ++oy) {
+            int16_t y = dstY + oy;
+            if (y < 0 || y >= (int16_t)PIXEL_ROWS) continue;
+
+            // Map output y -> source y (nearest)
+            int16_t sy = oy / scale;
+            if (flipY) sy = (int16_t)spr.height - 1 - sy;
+
+            const uint8_t row = y / 3;
+            const uint8_t subRow = (y % 3) * 2;
+            const uint8_t* src = base + sy * stride;
+
+            for (int16_t sx = 0; sx < spr.width; ++sx) {
+                bool v;
+                if (packed) {
+                    uint8_t bits = spriteByte(spr, src + (sx >> 3));
+                    if (bits == 0) {
+                        sx |= 7; // whole byte is transparent
+                        continue;
+                    }
+                    v = (bits & (0x80 >> (sx & 7))) != 0;
+                } else {
+                    v = spriteByte(spr, src + sx) != 0;
+                }
+                if (!v) continue;
+
+                int16_t ox = (flipX ? (int16_t)spr.width - 1 - sx : sx) * scale;
+                for (uint8_t s = 0; s < scale; ++s) {
+                    int16_t x = dstX + ox + s;
+                    if (x < 0 || x >= (int16_t)PIXEL_COLS) continue;
+
+                    setSubPixelByChar(x >> 1, row, subRow + (x & 1), on);
+                    if (drawMode_ == DrawMode::Immediate) {
+                        updateCellOnScreen(x >> 1, row);
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    // Pre-rotated frame: as cheap as an unrotated blit
+    if (rotationCached(spr, scale, flipX, flipY)) {
+        uint8_t step = rotationStep(spr, angleDeg);
+        Sprite sq;
+        sq.format = SpriteFormat::Packed;
+        sq.width = sq.height = spr.rotSide;
+        sq.frameCount = 1;
+        sq.frames = spr.rotCache + ((uint32_t)frameIndex * spr.rotSteps + step) *
+                                   rotationFrameSize(spr.rotSide);
+        spriteBlitCells(sq, sq.frames,
+                        dstX + rotationOrigin(spr.width, spr.rotSide),
+                        dstY + rotationOrigin(spr.height, spr.rotSide),
+                        false, false, on);
+        return;
+    }
+
+    // General case: rotation around the scaled sprite centre, in fixed
+    // point, scanning only the box the rotated sprite can cover.
+    const int16_t ca = cosQ14(angleDeg);
+    const int16_t sa = sinQ14(angleDeg);
+
+    int16_t x0, y0, x1, y1;
+    rotatedExtent(outW, outH, ca, sa, x0, y0, x1, y1);
+
+    // Clamp to screen
+    if (x0 < -dstX) x0 = -dstX;
+    if (y0 < -dstY) y0 = -dstY;
+    if (x1 > (int16_t)PIXEL_COLS - 1 - dstX) x1 = PIXEL_COLS - 1 - dstX;
+    if (y1 > (int16_t)PIXEL_ROWS - 1 - dstY) y1 = PIXEL_ROWS - 1 - dstY;
+
+    rotateScan(spr, base, scale, ca, sa, flipX, flipY, x0, y0, x1, y1,
+               [&](int16_t x, int16_t y) { drawPixel(dstX + x, dstY + y, on); });
+}
+
+// ---------------------- Rotation cache -------------------------
+
+template <uint8_t Cols, uint8_t Rows>
+uint16_t MinitelGfxT<Cols, Rows>::rotationFrameSize(uint8_t side)
+{
+    return (uint16_t)side * ((side + 7) / 8);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint8_t MinitelGfxT<Cols, Rows>::rotationStep(const Sprite& spr, int16_t angleDeg)
+{
+    // Nearest cached angle
+    uint16_t step = ((uint32_t)angleDeg * spr.rotSteps + 180) / 360;
+    return (step >= spr.rotSteps) ? 0 : (uint8_t)step;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::rotationCached(const Sprite& spr, uint8_t scale,
+                                bool flipX, bool flipY)
+{
+    // Built from the unscaled, unflipped frames
+    return spr.rotCache && scale == 1 && !flipX && !flipY;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+uint16_t MinitelGfxT<Cols, Rows>::spriteRotationCacheSize(const Sprite& spr, uint8_t steps)
+{
+    return (uint16_t)spr.frameCount * steps *
+           rotationFrameSize(rotationSide(spr.width, spr.height));
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::spriteCacheRotations(Sprite& spr, uint8_t* buffer,
+                                      uint16_t size, uint8_t steps)
+{
+    if (!spr.frames || spr.width == 0 || spr.height == 0 ||
+        spr.frameCount == 0 || steps == 0 || !buffer)
+        return false;
+    if (size < spriteRotationCacheSize(spr, steps))
+        return false;
+
+    const uint8_t side = rotationSide(spr.width, spr.height);
+    const uint8_t sqStride = (side + 7) / 8;
+    const int16_t ox0 = rotationOrigin(spr.width, side);
+    const int16_t oy0 = rotationOrigin(spr.height, side);
+    const uint8_t stride = spriteStride(spr);
+
+    memset(buffer, 0, spriteRotationCacheSize(spr, steps));
+
+    uint8_t* out = buffer;
+    for (uint8_t f = 0; f < spr.frameCount; ++f) {
+        const uint8_t* base = spr.frames + (uint32_t)f * stride * spr.height;
+
+        for (uint8_t i = 0; i < steps; ++i) {
+            int16_t a = (int16_t)(((uint32_t)i * 360) / steps);
+            rotateScan(spr, base, 1, cosQ14(a), sinQ14(a), false, false,
+                       ox0, oy0, ox0 + side - 1, oy0 + side - 1,
+                       [&](int16_t x, int16_t y) {
+                           uint8_t u = x - ox0;
+                           out[(y - oy0) * sqStride + (u >> 3)] |= 0x80 >> (u & 7);
+                       });
+            out += rotationFrameSize(side);
+        }
+    }
+
+    spr.rotCache = buffer;
+    spr.rotSteps = steps;
+    spr.rotSide = side;
+    return true;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteClearRotationCache(Sprite& spr)
+{
+    spr.rotCache = nullptr;
+    spr.rotSteps = 0;
+    spr.rotSide = 0;
+}
+
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteDraw(Sprite& spr) {
+    Batch batch(*this);
+    if (!spr.visible) return;
+
+    if (!spr.firstDraw) {
+        spriteBlitFrame(spr,
+                        spr.prevX, spr.prevY,
+                        spr.prevFrame,
+                        spr.prevAngleDeg,
+                        spr.prevScale,
+                        spr.prevFlipX,
+                        spr.prevFlipY,
+                        false);
+    }
+
+    spriteBlitFrame(spr,
+                    spr.x, spr.y,
+                    spr.frame,
+                    spr.angleDeg,
+                    spr.scale,
+                    spr.flipX,
+                    spr.flipY,
+                    true);
+
+    spr.prevX        = spr.x;
+    spr.prevY        = spr.y;
+    spr.prevFrame    = spr.frame;
+    spr.prevAngleDeg = spr.angleDeg;
+    spr.prevScale    = spr.scale;
+    spr.prevFlipX    = spr.flipX;
+    spr.prevFlipY    = spr.flipY;
+    spr.firstDraw    = false;
+}
+
+
+
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteBlit(const Sprite& spr, bool on)
+{
+    Batch batch(*this);
+    spriteBlitFrame(spr,
+                    spr.x, spr.y,
+                    spr.frame,
+                    spr.angleDeg,
+                    spr.scale,
+                    spr.flipX,
+                    spr.flipY,
+                    on);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+bool MinitelGfxT<Cols, Rows>::spriteBounds(const Sprite& spr,
+                              int16_t &x0, int16_t &y0,
+                              int16_t &x1, int16_t &y1) const
+{
+    if (!spr.frames || spr.width == 0 || spr.height == 0 ||
+        spr.frameCount == 0)
+        return false;
+
+    uint8_t scale = spr.scale;
+    if (scale < 1) scale = 1;
+    if (scale > 6) scale = 6;
+
+    const int16_t outW = (int16_t)spr.width  * (int16_t)scale;
+    const int16_t outH = (int16_t)spr.height * (int16_t)scale;
+
+    const int16_t angle = normalizeAngleDeg(spr.angleDeg);
+    if (angle == 0) {
+        x0 = 0;
+        y0 = 0;
+        x1 = outW - 1;
+        y1 = outH - 1;
+    } else if (rotationCached(spr, scale, spr.flipX, spr.flipY)) {
+        x0 = rotationOrigin(spr.width, spr.rotSide);
+        y0 = rotationOrigin(spr.height, spr.rotSide);
+        x1 = x0 + spr.rotSide - 1;
+        y1 = y0 + spr.rotSide - 1;
+    } else {
+        // Same box as the rotated blit scans
+        rotatedExtent(outW, outH, cosQ14(angle), sinQ14(angle),
+                      x0, y0, x1, y1);
+    }
+
+    x0 += spr.x;
+    y0 += spr.y;
+    x1 += spr.x;
+    y1 += spr.y;
+    return true;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteSetAngle(Sprite &spr, int16_t angleDeg)
+{
+    spr.angleDeg = normalizeAngleDeg(angleDeg);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteRotateBy(Sprite &spr, int16_t deltaDeg)
+{
+    spr.angleDeg = normalizeAngleDeg(spr.angleDeg + deltaDeg);
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteSetFlip(Sprite& spr, bool flipX, bool flipY) {
+    spr.flipX = flipX;
+    spr.flipY = flipY;
+}
+
+template <uint8_t Cols, uint8_t Rows>
+void MinitelGfxT<Cols, Rows>::spriteSetScale(Sprite& spr, uint8_t scale) {
+    if (scale < 1) scale = 1;
+    // optional clamp to keep it sane on Mega
+    if (scale > 6) scale = 6;
+    spr.scale = scale;
+}
\ No newline at end of file
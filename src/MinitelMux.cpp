@@ -0,0 +1,93 @@
+#include "MinitelMux.h"
+
+// ---------------------- MinitelMux -------------------------
+
+bool MinitelMux::add(Minitel &term, MinitelGfx *gfx)
+{
+    if (count_ >= MINITEL_MUX_MAX_PORTS)
+        return false;
+    ports_[count_].term = &term;
+    ports_[count_].gfx = gfx;
+    ++count_;
+    return true;
+}
+
+void MinitelMux::poll()
+{
+    if (count_ == 0)
+        return;
+    if (next_ >= count_)
+        next_ = 0;
+
+    for (uint8_t n = 0, i = next_; n < count_; ++n)
+    {
+        ports_[i].term->poll();
+        if (++i == count_)
+            i = 0;
+    }
+    next_++;
+}
+
+uint8_t MinitelMux::flush(MinitelGfx::FlushMode mode)
+{
+    uint8_t flushed = 0;
+    for (uint8_t i = 0; i < count_; ++i)
+        if (ports_[i].gfx && ports_[i].gfx->flushIfRoom(mode))
+            ++flushed;
+    return flushed;
+}
+
+// ---------------------- MinitelTee -------------------------
+
+bool MinitelTee::add(Stream *port)
+{
+    if (count_ >= MINITEL_MUX_MAX_PORTS || !port)
+        return false;
+    ports_[count_++] = port;
+    return true;
+}
+
+size_t MinitelTee::write(uint8_t b)
+{
+    for (uint8_t i = 0; i < count_; ++i)
+        ports_[i]->write(b);
+    return 1;
+}
+
+int MinitelTee::availableForWrite()
+{
+    if (count_ == 0)
+        return 0;
+    int room = ports_[0]->availableForWrite();
+    for (uint8_t i = 1; i < count_; ++i)
+    {
+        int r = ports_[i]->availableForWrite();
+        if (r < room)
+            room = r;
+    }
+    return room;
+}
+
+void MinitelTee::flush()
+{
+    for (uint8_t i = 0; i < count_; ++i)
+        ports_[i]->flush();
+}
+
+int MinitelTee::available()
+{
+    Stream *in = inputPort();
+    return in ? in->available() : 0;
+}
+
+int MinitelTee::read()
+{
+    Stream *in = inputPort();
+    return in ? in->read() : -1;
+}
+
+int MinitelTee::peek()
+{
+    Stream *in = inputPort();
+    return in ? in->peek() : -1;
+}
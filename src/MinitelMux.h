@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Minitel.h"
+#include "MinitelGfx.h"
+
+// Most terminals one MinitelMux, or ports one MinitelTee, can drive
+#ifndef MINITEL_MUX_MAX_PORTS
+#define MINITEL_MUX_MAX_PORTS 4
+#endif
+
+// Several terminals from one sketch, e.g. three Minitels on the UARTs of
+// a Mega, each with its own Minitel (and MinitelGfx, if it draws):
+//
+//   MinitelMux mux;
+//   mux.add(term1, &gfx1);
+//   mux.add(term2, &gfx2);
+//   mux.add(term3);                 // text only
+//
+//   void loop() {
+//     mux.poll();                   // every terminal, a bounded turn each
+//     ... read events from mux.terminal(i), draw on the gfx ...
+//     mux.flush();                  // only where the link has room
+//   }
+//
+// Nothing waits for a slow link: poll() reads at most each terminal's
+// RX budget and drains what its serial port takes, and flush() goes
+// through flushIfRoom(), so a terminal that is behind drops frames (they
+// coalesce into its next diff) instead of stalling the others. Set the
+// backlog with setFlushBacklog() on each MinitelGfx.
+//
+// Sprites and other PROGMEM assets are only pointed to, so any number of
+// MinitelGfx share them. Each MinitelGfx keeps its own shadow (about
+// 3.8 KB, 2.9 KB with MGFX_COMPACT_SHADOW); for identical content use a
+// MinitelTee instead, with one of each.
+class MinitelMux
+{
+public:
+    // False if MINITEL_MUX_MAX_PORTS terminals are there already
+    bool add(Minitel &term, MinitelGfx *gfx = nullptr);
+
+    uint8_t size() const { return count_; }
+    Minitel &terminal(uint8_t i) { return *ports_[i].term; }
+    MinitelGfx *gfx(uint8_t i) { return ports_[i].gfx; }
+
+    // One poll() of each terminal, starting with a different one on
+    // each call so that none always comes first.
+    void poll();
+
+    // flushIfRoom() on each MinitelGfx. Returns how many flushed.
+    uint8_t flush(MinitelGfx::FlushMode mode = MinitelGfx::FlushMode::OptimizedDiff);
+
+private:
+    struct Port
+    {
+        Minitel *term;
+        MinitelGfx *gfx;
+    };
+
+    Port ports_[MINITEL_MUX_MAX_PORTS];
+    uint8_t count_ = 0;
+    uint8_t next_ = 0; // first one polled next time
+};
+
+// Broadcast: a Stream that writes every byte to several ports, so one
+// Minitel and one MinitelGfx encode each diff once for all terminals.
+//
+//   MinitelTee tee;
+//   tee.add(&Serial1);
+//   tee.add(&Serial2);
+//   tee.add(&Serial3);
+//   minitel.begin(&tee);
+//
+// availableForWrite() is the least room of all ports, so the TX queue
+// drains at the pace of the slowest link and never blocks on any. A
+// port that does not implement it (SoftwareSerial...) makes it 0: then
+// Minitel::begin() stops checking it, and the queue drains blocking.
+// Input is read from one port only (the first by default, see
+// setInputPort()): it answers the requests sent to all (session,
+// PRO3 acknowledgements...) and its keyboard drives the shared screen.
+// The terminals must run at the same speed.
+class MinitelTee : public Stream
+{
+public:
+    // False if MINITEL_MUX_MAX_PORTS ports are there already
+    bool add(Stream *port);
+
+    uint8_t size() const { return count_; }
+
+    // Port whose input is read (others are left unread)
+    void setInputPort(uint8_t i) { input_ = i; }
+
+    size_t write(uint8_t b) override;
+    int availableForWrite() override;
+    void flush() override;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+
+private:
+    Stream *ports_[MINITEL_MUX_MAX_PORTS];
+    uint8_t count_ = 0;
+    uint8_t input_ = 0;
+
+    Stream *inputPort() const { return input_ < count_ ? ports_[input_] : nullptr; }
+};
@@ -0,0 +1,128 @@
+#include "MinitelRecorder.h"
+
+static_assert(MINITEL_RECORDER_SIZE >= 2 && MINITEL_RECORDER_SIZE <= 0xFFFF,
+              "MINITEL_RECORDER_SIZE must be 2..65535");
+
+MinitelRecorder::MinitelRecorder(Stream &port)
+    : port_(port)
+{
+}
+
+void MinitelRecorder::attach(Minitel &dev)
+{
+    dev.setTraceHook(&MinitelRecorder::onTrace, this);
+}
+
+void MinitelRecorder::onTrace(Minitel::Trace what, uint16_t arg, void *ctx)
+{
+    MinitelRecorder *rec = static_cast<MinitelRecorder *>(ctx);
+    if (rec->on_)
+        rec->markAt((uint8_t)what, arg, micros());
+}
+
+// ---------------------- Recording -------------------------
+
+void MinitelRecorder::start()
+{
+    last_ = micros();
+    on_ = true;
+}
+
+void MinitelRecorder::clear()
+{
+    head_ = 0;
+    count_ = 0;
+    dropped_ = 0;
+    last_ = micros();
+}
+
+const MinitelRecorder::Record &MinitelRecorder::record(uint16_t i) const
+{
+    uint16_t first = (count_ < MINITEL_RECORDER_SIZE) ? 0 : head_;
+    return ring_[(uint16_t)((first + (uint32_t)i) % MINITEL_RECORDER_SIZE)];
+}
+
+void MinitelRecorder::put(uint8_t kind, uint8_t value, uint16_t data)
+{
+    Record &r = ring_[head_];
+    r.kind = kind;
+    r.value = value;
+    r.data = data;
+    if (++head_ == MINITEL_RECORDER_SIZE)
+        head_ = 0;
+    if (count_ < MINITEL_RECORDER_SIZE)
+        ++count_;
+    else
+        ++dropped_;
+}
+
+void MinitelRecorder::stamp(uint8_t kind, uint8_t value, unsigned long now)
+{
+    unsigned long dt = now - last_;
+    last_ = now;
+    if (dt > 0xFFFF)
+    {
+        // Longer than 65 ms: the high part first (saturated past ~71 min)
+        unsigned long high = dt >> 16;
+        put(TIME, 0, high > 0xFFFF ? 0xFFFF : (uint16_t)high);
+    }
+    put(kind, value, (uint16_t)dt);
+}
+
+void MinitelRecorder::markAt(uint8_t kind, uint16_t arg, unsigned long now)
+{
+    stamp(MARK, kind, now);
+    put(ARG, 0, arg);
+}
+
+void MinitelRecorder::mark(uint8_t kind, uint16_t arg)
+{
+    if (on_)
+        markAt(kind, arg, micros());
+}
+
+// ---------------------- Stream -------------------------
+
+size_t MinitelRecorder::write(uint8_t b)
+{
+    if (!on_)
+        return port_.write(b);
+
+    unsigned long t0 = micros();
+    size_t n = port_.write(b);
+    unsigned long now = micros();
+
+    // Stamped when the port took it, after the wait if it had no room
+    unsigned long spent = now - t0;
+    if (spent >= MINITEL_RECORDER_BLOCK_US)
+        markAt(BLOCKED, spent > 0xFFFF ? 0xFFFF : (uint16_t)spent, t0);
+    stamp(TX, b, now);
+    return n;
+}
+
+int MinitelRecorder::read()
+{
+    int c = port_.read();
+    if (on_ && c >= 0)
+        stamp(RX, (uint8_t)c, micros());
+    return c;
+}
+
+// ---------------------- Dump -------------------------
+
+void MinitelRecorder::dump(Print &out) const
+{
+    uint8_t head[HEADER_BYTES] = {
+        'M', 'R', 'E', 'C', VERSION, sizeof(Record),
+        (uint8_t)count_, (uint8_t)(count_ >> 8),
+        (uint8_t)dropped_, (uint8_t)(dropped_ >> 8),
+        (uint8_t)(dropped_ >> 16), (uint8_t)(dropped_ >> 24)};
+    out.write(head, sizeof(head));
+
+    for (uint16_t i = 0; i < count_; ++i)
+    {
+        const Record &r = record(i);
+        uint8_t b[4] = {r.kind, r.value, (uint8_t)r.data, (uint8_t)(r.data >> 8)};
+        out.write(b, sizeof(b));
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Minitel.h"
+
+// Records kept (4 bytes each); the oldest go first when it is full
+#ifndef MINITEL_RECORDER_SIZE
+#define MINITEL_RECORDER_SIZE 128
+#endif
+
+// A write() to the port taking this long (µs) is marked BLOCKED
+#ifndef MINITEL_RECORDER_BLOCK_US
+#define MINITEL_RECORDER_BLOCK_US 100
+#endif
+
+// What went over the wire, and when: a Stream between the Minitel and
+// its serial port that stamps every byte written and read with micros(),
+// along with the driver's trace points (flushes, transactions), for a
+// latency profile of a real session:
+//
+//   MinitelRecorder rec(Serial1);
+//   minitel.begin(&rec);
+//   rec.attach(minitel);             // flush / transaction marks
+//   rec.start();
+//   ...
+//   rec.stop();
+//   rec.dump(Serial);                // binary, see below
+//
+// extras/host/replay reads the dump back: a timeline of each frame
+// (encoding time, bytes, time until its last byte was on the wire, time
+// blocked in the port) and of each request / reply, and the size of the
+// same frames from the current encoder.
+//
+// TX bytes are stamped as the port takes them (from poll()'s drain, or
+// from writeRaw() when the queue is empty, full or absent), RX bytes as
+// poll() reads them. Recording costs two micros() and a few stores per
+// byte.
+//
+// Each record is {kind, value, data}: data is the time since the
+// previous record (µs), except in an ARG record where it is the 16-bit
+// argument of the MARK before. A TIME record before one adds data << 16
+// µs to its delay. dump() writes a 12-byte header ("MREC", version,
+// record size, record count: 16 bits, dropped count: 32 bits), then the
+// records from the oldest, multi-byte fields little-endian.
+class MinitelRecorder : public Stream
+{
+public:
+    enum Kind : uint8_t
+    {
+        TX,   // value: the byte written
+        RX,   // value: the byte read
+        MARK, // value: a Mark, followed by its ARG
+        ARG,
+        TIME
+    };
+
+    enum Mark : uint8_t
+    {
+        // 0..0x0F: Minitel::Trace points
+        BLOCKED = 0x10, // arg: µs spent in the port's write()
+        USER = 0x80     // and up: the sketch's own, see mark()
+    };
+
+    struct Record
+    {
+        uint8_t kind;
+        uint8_t value;
+        uint16_t data;
+    };
+
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t HEADER_BYTES = 12;
+
+    explicit MinitelRecorder(Stream &port);
+
+    // Record dev's trace points (through its trace hook)
+    void attach(Minitel &dev);
+
+    void start();
+    void stop() { on_ = false; }
+    bool recording() const { return on_; }
+    void clear();
+
+    // Records kept, oldest first, and records lost to the ring
+    uint16_t size() const { return count_; }
+    const Record &record(uint16_t i) const;
+    uint32_t dropped() const { return dropped_; }
+
+    // A mark of the sketch's own (USER + n) on the timeline
+    void mark(uint8_t kind, uint16_t arg = 0);
+
+    void dump(Print &out) const;
+
+    size_t write(uint8_t b) override;
+    int availableForWrite() override { return port_.availableForWrite(); }
+    void flush() override { port_.flush(); }
+
+    int available() override { return port_.available(); }
+    int read() override;
+    int peek() override { return port_.peek(); }
+
+private:
+    Stream &port_;
+    bool on_ = false;
+    unsigned long last_ = 0; // micros() of the last record
+    uint16_t head_ = 0;      // next one written
+    uint16_t count_ = 0;
+    uint32_t dropped_ = 0;
+    Record ring_[MINITEL_RECORDER_SIZE];
+
+    void put(uint8_t kind, uint8_t value, uint16_t data);
+    void stamp(uint8_t kind, uint8_t value, unsigned long now);
+    void markAt(uint8_t kind, uint16_t arg, unsigned long now);
+    static void onTrace(Minitel::Trace what, uint16_t arg, void *ctx);
+};
@@ -0,0 +1,271 @@
+#include "MinitelSpriteLayer.h"
+
+MinitelSpriteLayer::MinitelSpriteLayer(MinitelGfx &gfx)
+    : gfx_(gfx)
+{
+}
+
+// ---------------------- Configuration -------------------------
+
+void MinitelSpriteLayer::setBackground(const MinitelGfx::Sprite *bg,
+                                       Minitel::Color color)
+{
+    bgSprite_ = bg;
+    bgColor_ = static_cast<uint8_t>(color);
+    bgFn_ = nullptr;
+    full_ = true;
+}
+
+void MinitelSpriteLayer::setBackground(BackgroundFn fn, void *ctx)
+{
+    bgSprite_ = nullptr;
+    bgFn_ = fn;
+    bgCtx_ = ctx;
+    full_ = true;
+}
+
+int8_t MinitelSpriteLayer::find(const MinitelGfx::Sprite &spr) const
+{
+    for (uint8_t i = 0; i < count_; ++i)
+        if (entries_[i].spr == &spr)
+            return i;
+    return -1;
+}
+
+void MinitelSpriteLayer::insert(const Entry &e)
+{
+    // After every entry with z <= e.z: equal z keeps insertion order
+    uint8_t pos = count_;
+    while (pos > 0 && entries_[pos - 1].z > e.z)
+    {
+        entries_[pos] = entries_[pos - 1];
+        --pos;
+    }
+    entries_[pos] = e;
+    ++count_;
+}
+
+bool MinitelSpriteLayer::add(MinitelGfx::Sprite &spr, uint8_t z,
+                             Minitel::Color color)
+{
+    if (count_ >= MGFX_LAYER_MAX_SPRITES || find(spr) >= 0)
+        return false;
+
+    Entry e = {};
+    e.spr = &spr;
+    e.z = z;
+    e.color = static_cast<uint8_t>(color);
+    e.dirty = true;
+    insert(e);
+    return true;
+}
+
+void MinitelSpriteLayer::remove(MinitelGfx::Sprite &spr)
+{
+    int8_t i = find(spr);
+    if (i < 0)
+        return;
+
+    if (entries_[i].shown)
+    {
+        if (holeCount_ < MGFX_LAYER_MAX_SPRITES)
+            holes_[holeCount_++] = entries_[i].box;
+        else
+            full_ = true;
+    }
+
+    for (uint8_t j = i; j + 1 < count_; ++j)
+        entries_[j] = entries_[j + 1];
+    --count_;
+}
+
+void MinitelSpriteLayer::setZ(MinitelGfx::Sprite &spr, uint8_t z)
+{
+    int8_t i = find(spr);
+    if (i < 0 || entries_[i].z == z)
+        return;
+
+    Entry e = entries_[i];
+    for (uint8_t j = i; j + 1 < count_; ++j)
+        entries_[j] = entries_[j + 1];
+    --count_;
+
+    e.z = z;
+    e.dirty = true;
+    insert(e);
+}
+
+void MinitelSpriteLayer::setColor(MinitelGfx::Sprite &spr,
+                                  Minitel::Color color)
+{
+    int8_t i = find(spr);
+    if (i < 0 || entries_[i].color == static_cast<uint8_t>(color))
+        return;
+
+    entries_[i].color = static_cast<uint8_t>(color);
+    entries_[i].dirty = true;
+}
+
+// ---------------------- Geometry -------------------------
+
+bool MinitelSpriteLayer::moved(const MinitelGfx::Sprite &spr)
+{
+    return spr.x != spr.prevX || spr.y != spr.prevY ||
+           spr.frame != spr.prevFrame ||
+           spr.angleDeg != spr.prevAngleDeg ||
+           spr.scale != spr.prevScale ||
+           spr.flipX != spr.prevFlipX || spr.flipY != spr.prevFlipY;
+}
+
+bool MinitelSpriteLayer::overlap(const Rect &a, const Rect &b)
+{
+    return a.col0 <= b.col1 && b.col0 <= a.col1 &&
+           a.row0 <= b.row1 && b.row0 <= a.row1;
+}
+
+bool MinitelSpriteLayer::cellBox(const MinitelGfx::Sprite &spr,
+                                 Rect &box) const
+{
+    int16_t x0, y0, x1, y1;
+    if (!gfx_.spriteBounds(spr, x0, y0, x1, y1))
+        return false;
+
+    if (x1 < 0 || y1 < 0 ||
+        x0 >= (int16_t)MinitelGfx::PIXEL_COLS ||
+        y0 >= (int16_t)MinitelGfx::PIXEL_ROWS)
+        return false;
+
+    box.col0 = (x0 < 0) ? 0 : x0 / 2;
+    box.row0 = (y0 < 0) ? 0 : y0 / 3;
+    box.col1 = (x1 >= (int16_t)MinitelGfx::PIXEL_COLS)
+                   ? MinitelGfx::CELL_COLS - 1 : x1 / 2;
+    box.row1 = (y1 >= (int16_t)MinitelGfx::PIXEL_ROWS)
+                   ? MinitelGfx::CELL_ROWS - 1 : y1 / 3;
+    return true;
+}
+
+// ---------------------- Composition -------------------------
+
+void MinitelSpriteLayer::compose(const Rect &area)
+{
+    gfx_.setClipCells(area.col0, area.row0, area.col1, area.row1);
+    gfx_.clearCells(area.col0, area.row0, area.col1, area.row1);
+
+    if (bgFn_)
+    {
+        bgFn_(gfx_, bgCtx_);
+    }
+    else if (bgSprite_)
+    {
+        gfx_.setDrawColor(static_cast<Minitel::Color>(bgColor_));
+        gfx_.spriteBlit(*bgSprite_);
+    }
+
+    for (uint8_t i = 0; i < count_; ++i)
+    {
+        const Entry &e = entries_[i];
+        if (!e.nextShown || !overlap(e.nextBox, area))
+            continue;
+        gfx_.setDrawColor(static_cast<Minitel::Color>(e.color));
+        gfx_.spriteBlit(*e.spr);
+    }
+}
+
+void MinitelSpriteLayer::update()
+{
+    // In Streaming mode, the whole recomposition goes out as one diff
+    gfx_.beginBatch();
+
+    // Old and new box of each changed sprite, plus removed ones
+    Rect areas[3 * MGFX_LAYER_MAX_SPRITES];
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < count_; ++i)
+    {
+        Entry &e = entries_[i];
+        e.nextShown = e.spr->visible && cellBox(*e.spr, e.nextBox);
+
+        if (full_ || !(e.dirty || e.shown != e.nextShown ||
+                       (e.shown && moved(*e.spr))))
+            continue;
+        if (e.shown)
+            areas[n++] = e.box;
+        if (e.nextShown)
+            areas[n++] = e.nextBox;
+    }
+
+    for (uint8_t i = 0; i < holeCount_; ++i)
+        areas[n++] = holes_[i];
+
+    if (full_)
+    {
+        areas[0].col0 = 0;
+        areas[0].row0 = 0;
+        areas[0].col1 = MinitelGfx::CELL_COLS - 1;
+        areas[0].row1 = MinitelGfx::CELL_ROWS - 1;
+        n = 1;
+    }
+
+    // Merge overlapping areas so that no cell is composed twice. A grown
+    // area may now overlap one it was checked against: repeat until a
+    // pass merges nothing.
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (uint8_t i = 0; i < n; ++i)
+        {
+            for (uint8_t j = i + 1; j < n; ++j)
+            {
+                if (!overlap(areas[i], areas[j]))
+                    continue;
+                Rect &a = areas[i];
+                const Rect &b = areas[j];
+                if (b.col0 < a.col0) a.col0 = b.col0;
+                if (b.row0 < a.row0) a.row0 = b.row0;
+                if (b.col1 > a.col1) a.col1 = b.col1;
+                if (b.row1 > a.row1) a.row1 = b.row1;
+                areas[j--] = areas[--n]; // the last one moves in at j
+                merged = true;
+            }
+        }
+    }
+
+    if (n > 0)
+    {
+        // Compose in the bitmap only: flush() sends the net result
+        MinitelGfx::DrawMode mode = gfx_.drawMode();
+        Minitel::Color color = gfx_.drawColor();
+        gfx_.setDrawMode(MinitelGfx::DrawMode::BitmapOnly);
+
+        for (uint8_t i = 0; i < n; ++i)
+            compose(areas[i]);
+
+        gfx_.resetClip();
+        gfx_.setDrawColor(color);
+        gfx_.setDrawMode(mode);
+    }
+
+    for (uint8_t i = 0; i < count_; ++i)
+    {
+        Entry &e = entries_[i];
+        MinitelGfx::Sprite &spr = *e.spr;
+        e.shown = e.nextShown;
+        e.box = e.nextBox;
+        e.dirty = false;
+
+        spr.prevX = spr.x;
+        spr.prevY = spr.y;
+        spr.prevFrame = spr.frame;
+        spr.prevAngleDeg = spr.angleDeg;
+        spr.prevScale = spr.scale;
+        spr.prevFlipX = spr.flipX;
+        spr.prevFlipY = spr.flipY;
+        spr.firstDraw = false;
+    }
+
+    holeCount_ = 0;
+    full_ = false;
+
+    gfx_.endBatch();
+}
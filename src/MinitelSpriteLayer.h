@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+#include "MinitelGfx.h"
+
+// Maximum number of sprites one layer can manage
+#ifndef MGFX_LAYER_MAX_SPRITES
+#define MGFX_LAYER_MAX_SPRITES 8
+#endif
+
+// Sprite manager with z-order and a background.
+//
+// Instead of erasing and redrawing each sprite by hand (which punches
+// holes in overlapping sprites and in the background), the layer owns
+// its sprites and, on update(), recomposes only the cells a change may
+// have touched: the old and new bounding boxes of every sprite that
+// moved, animated, turned, was shown/hidden or removed. Each of those
+// areas is rebuilt from the background, then every sprite in z-order.
+// Cells that end up identical to the screen are skipped by flush().
+//
+//   MinitelSpriteLayer layer(gfx);
+//   layer.setBackground(drawMaze);             // or a full-screen Sprite
+//   layer.add(ghost, 1, Minitel::Color::Red);
+//   layer.add(pacman, 2, Minitel::Color::Yellow);
+//
+//   // on each frame:
+//   gfx.spriteSetPosition(pacman, x, y);
+//   gfx.spriteNextFrame(ghost);
+//   layer.update();
+//   gfx.flush();
+//
+// Sprites owned by a layer must not be drawn with spriteDraw(). The
+// layer works on the full screen MinitelGfx.
+class MinitelSpriteLayer
+{
+public:
+    // Redraws the background. The clip is set to the area being
+    // recomposed, so it may simply draw everything.
+    typedef void (*BackgroundFn)(MinitelGfx &gfx, void *ctx);
+
+    explicit MinitelSpriteLayer(MinitelGfx &gfx);
+
+    // Background: blank (default), a sprite drawn in `color` (e.g. an
+    // 80x72 PackedProgmem image), or a drawing callback.
+    void setBackground(const MinitelGfx::Sprite *bg,
+                       Minitel::Color color = Minitel::Color::White);
+    void setBackground(BackgroundFn fn, void *ctx = nullptr);
+
+    // Add a sprite drawn in `color`. Higher z is drawn on top; equal z
+    // keeps insertion order. False if the layer is full or it is there.
+    bool add(MinitelGfx::Sprite &spr, uint8_t z = 0,
+             Minitel::Color color = Minitel::Color::White);
+    void remove(MinitelGfx::Sprite &spr);
+
+    void setZ(MinitelGfx::Sprite &spr, uint8_t z);
+    void setColor(MinitelGfx::Sprite &spr, Minitel::Color color);
+
+    uint8_t count() const { return count_; }
+
+    // Recompose the whole screen on the next update() (e.g. after the
+    // background content changed).
+    void invalidate() { full_ = true; }
+
+    // Recompose what changed since the last update(). Does not flush.
+    void update();
+
+private:
+    struct Rect
+    {
+        uint8_t col0, row0, col1, row1; // cells, inclusive
+    };
+
+    struct Entry
+    {
+        MinitelGfx::Sprite *spr;
+        uint8_t z;
+        uint8_t color;
+        bool dirty;  // z / colour changed
+        bool shown;  // composed on screen, in `box`
+        Rect box;
+        bool nextShown; // state being composed by update()
+        Rect nextBox;
+    };
+
+    MinitelGfx &gfx_;
+
+    Entry entries_[MGFX_LAYER_MAX_SPRITES]; // sorted by z
+    uint8_t count_ = 0;
+
+    // Areas left by removed sprites
+    Rect holes_[MGFX_LAYER_MAX_SPRITES];
+    uint8_t holeCount_ = 0;
+    bool full_ = true;
+
+    const MinitelGfx::Sprite *bgSprite_ = nullptr;
+    uint8_t bgColor_ = static_cast<uint8_t>(Minitel::Color::White);
+    BackgroundFn bgFn_ = nullptr;
+    void *bgCtx_ = nullptr;
+
+    int8_t find(const MinitelGfx::Sprite &spr) const;
+    void insert(const Entry &e);
+    bool cellBox(const MinitelGfx::Sprite &spr, Rect &box) const;
+    void compose(const Rect &area);
+
+    static bool moved(const MinitelGfx::Sprite &spr);
+    static bool overlap(const Rect &a, const Rect &b);
+};
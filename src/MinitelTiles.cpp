@@ -0,0 +1,151 @@
+#include "MinitelTiles.h"
+
+#include <string.h>
+
+static_assert(MINITEL_TILES_MAX >= 1 && MINITEL_TILES_MAX <= 94,
+              "MINITEL_TILES_MAX must be 1..94");
+static_assert(MINITEL_TILE_SLOTS >= 1 && MINITEL_TILE_SLOTS <= 94,
+              "MINITEL_TILE_SLOTS must be 1..94");
+
+MinitelTiles::MinitelTiles(Minitel &dev)
+    : dev_(dev)
+{
+    reset();
+}
+
+// ---------------------- Tiles -------------------------
+
+uint8_t MinitelTiles::add(const uint8_t *rows)
+{
+    if (count_ >= MINITEL_TILES_MAX || !rows)
+        return NONE;
+
+    rows_[count_] = rows;
+    mosaic_[count_] = mosaicOf(rows);
+    slot_[count_] = 0;
+    return count_++;
+}
+
+void MinitelTiles::setEnabled(bool on)
+{
+    if (!on)
+        reset();
+    enabled_ = on;
+}
+
+void MinitelTiles::reset()
+{
+    memset(slot_, 0, sizeof(slot_));
+    memset(owner_, NONE, sizeof(owner_));
+    memset(used_, 0, sizeof(used_));
+}
+
+// Mosaic rows are 3, 4 and 3 pixels high, columns 4 wide. A block is
+// lit when at least half its pixels are.
+uint8_t MinitelTiles::mosaicOf(const uint8_t *rows)
+{
+    static const uint8_t FIRST[3] = {0, 3, 7};
+    static const uint8_t HEIGHT[3] = {3, 4, 3};
+
+    uint8_t mask = 0;
+    bool exact = true;
+    for (uint8_t y = 0; y < 3; ++y)
+    {
+        for (uint8_t x = 0; x < 2; ++x)
+        {
+            uint8_t lit = 0;
+            for (uint8_t r = FIRST[y]; r < FIRST[y] + HEIGHT[y]; ++r)
+            {
+                uint8_t bits = pgm_read_byte(rows + r);
+                bits = x ? (bits & 0x0F) : (bits >> 4);
+                for (; bits; bits &= bits - 1)
+                    ++lit;
+            }
+            uint8_t all = 4 * HEIGHT[y];
+            if (lit != 0 && lit != all)
+                exact = false;
+            if (2 * lit >= all)
+                mask |= 1u << (y * 2 + x);
+        }
+    }
+    return mask | (exact ? EXACT : 0);
+}
+
+// ---------------------- Slots -------------------------
+
+uint8_t MinitelTiles::code(uint8_t id) const
+{
+    if (id >= count_ || slot_[id] == 0)
+        return 0;
+    return FIRST_CODE + slot_[id] - 1;
+}
+
+void MinitelTiles::touch(uint8_t id)
+{
+    if (id >= count_ || slot_[id] == 0)
+        return;
+    if (++clock_ == 0)
+    {
+        // Wrapped: halve every stamp, which keeps their order
+        for (uint8_t s = 0; s < MINITEL_TILE_SLOTS; ++s)
+            used_[s] >>= 1;
+        clock_ = 0x8000;
+    }
+    used_[slot_[id] - 1] = clock_;
+}
+
+void MinitelTiles::pin(uint8_t id, uint8_t *slots) const
+{
+    if (id >= count_ || slot_[id] == 0)
+        return;
+    uint8_t s = slot_[id] - 1;
+    slots[s / 8] |= 1u << (s % 8);
+}
+
+// A free slot, else the least recently drawn one; NONE if all are pinned
+uint8_t MinitelTiles::freeSlot(const uint8_t *pinned) const
+{
+    uint8_t best = NONE;
+    uint16_t bestAge = 0;
+    for (uint8_t s = 0; s < MINITEL_TILE_SLOTS; ++s)
+    {
+        if (pinned[s / 8] & (1u << (s % 8)))
+            continue;
+        if (owner_[s] == NONE)
+            return s;
+        uint16_t age = clock_ - used_[s];
+        if (best == NONE || age > bestAge)
+        {
+            best = s;
+            bestAge = age;
+        }
+    }
+    return best;
+}
+
+uint8_t MinitelTiles::load(const uint8_t *tiles, uint8_t *pinned)
+{
+    uint8_t sent = 0;
+    for (uint8_t id = 0; id < count_; ++id)
+    {
+        if (!(tiles[id / 8] & (1u << (id % 8))) || !wantsCode(id))
+            continue;
+
+        uint8_t s = freeSlot(pinned);
+        if (s == NONE)
+            break;
+        if (owner_[s] != NONE)
+            slot_[owner_[s]] = 0;
+
+        if (sent++ == 0)
+            dev_.beginDrcsLoad();
+        dev_.loadDrcsChar(FIRST_CODE + s, rows_[id], true);
+        ++uploads_;
+
+        owner_[s] = id;
+        slot_[id] = s + 1;
+        touch(id);
+        pinned[s / 8] |= 1u << (s % 8);
+    }
+    return sent;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Minitel.h"
+
+// Most tiles one MinitelTiles can hold (at most 94)
+#ifndef MINITEL_TILES_MAX
+#define MINITEL_TILES_MAX 48
+#endif
+
+// DRCS codes given to tiles, from 0x21 (at most 94)
+#ifndef MINITEL_TILE_SLOTS
+#define MINITEL_TILE_SLOTS 32
+#endif
+
+// Full 8x10 glyphs on the mosaic screen, through the terminal's
+// redefinable characters (DRCS): each tile is uploaded once, then every
+// cell showing it is a single byte (a REP run for a row of them).
+//
+//   static const uint8_t brick[10] PROGMEM = {
+//       MGFX_ROW8(1,1,1,1,1,1,1,0),
+//       ...                          // 10 rows, MSB = leftmost
+//   };
+//
+//   MinitelTiles tiles(minitel);
+//   uint8_t BRICK = tiles.add(brick);
+//   gfx.setTiles(&tiles);
+//   gfx.drawTile(3, 5, BRICK);
+//   gfx.flush();                     // uploads brick, then draws it
+//
+// MinitelGfx::flush() uploads a tile the first time it goes out (18
+// bytes) into one of MINITEL_TILE_SLOTS codes. When all are taken, the
+// least recently drawn tile that is not on screen gives up its code.
+// Tiles a mosaic renders exactly (blank, full, blocks) never take one.
+// A tile with no code to get, or all of them when setEnabled(false)
+// (terminals without DRCS), is drawn as its nearest 2x3 mosaic, and
+// stays so until drawn again.
+//
+// The terminal forgets the shapes when it is switched off: reset() and
+// redraw everything (FullRedraw) after such a power cycle.
+class MinitelTiles
+{
+public:
+    static constexpr uint8_t NONE = 0xFF;
+    static constexpr uint8_t FIRST_CODE = 0x21;
+
+    // Bytes of a set of tiles / of slots, one bit each
+    static constexpr uint8_t TILE_SET_BYTES = (MINITEL_TILES_MAX + 7) / 8;
+    static constexpr uint8_t SLOT_SET_BYTES = (MINITEL_TILE_SLOTS + 7) / 8;
+
+    // What load() sends: a header, then each shape
+    static constexpr uint8_t LOAD_HEADER_BYTES = 7;
+    static constexpr uint8_t LOAD_TILE_BYTES = 18;
+
+    explicit MinitelTiles(Minitel &dev);
+
+    // A tile: 10 rows of 8 pixels in flash. Returns its id, or NONE if
+    // MINITEL_TILES_MAX are there already.
+    uint8_t add(const uint8_t *rows);
+    uint8_t size() const { return count_; }
+
+    // False for terminals without DRCS: only mosaics are sent
+    void setEnabled(bool on);
+    bool enabled() const { return enabled_; }
+
+    // Every code free again, e.g. after the terminal was switched off
+    void reset();
+
+    // Shapes sent so far
+    uint16_t uploads() const { return uploads_; }
+
+    // ---- For MinitelGfx ----
+
+    // DRCS code of tile id, 0 if it has none now
+    uint8_t code(uint8_t id) const;
+    // Nearest 2x3 mosaic (MinitelGfx cell mask)
+    uint8_t mosaic(uint8_t id) const
+    {
+        return id < count_ ? mosaic_[id] & 0x3F : 0;
+    }
+    // Worth a code, and without one yet
+    bool wantsCode(uint8_t id) const
+    {
+        return enabled_ && id < count_ && !(mosaic_[id] & EXACT) &&
+               slot_[id] == 0;
+    }
+
+    // Tile id is being drawn (least recently drawn codes go first)
+    void touch(uint8_t id);
+    // Set the bit of the slot holding tile id, if any, in `slots`
+    void pin(uint8_t id, uint8_t *slots) const;
+
+    // Upload the tiles set in `tiles`, into slots not set in `pinned`
+    // (each one taken is set). Loading ends with the next cursor
+    // positioning. Returns how many were sent.
+    uint8_t load(const uint8_t *tiles, uint8_t *pinned);
+
+private:
+    static constexpr uint8_t EXACT = 0x80; // in mosaic_: no code needed
+
+    Minitel &dev_;
+    bool enabled_ = true;
+    uint8_t count_ = 0;
+    uint16_t clock_ = 0;
+    uint16_t uploads_ = 0;
+
+    const uint8_t *rows_[MINITEL_TILES_MAX];
+    uint8_t mosaic_[MINITEL_TILES_MAX];
+    uint8_t slot_[MINITEL_TILES_MAX];      // slot + 1, 0: none
+    uint8_t owner_[MINITEL_TILE_SLOTS];    // tile in each slot, or NONE
+    uint16_t used_[MINITEL_TILE_SLOTS];    // clock_ when last drawn
+
+    static uint8_t mosaicOf(const uint8_t *rows);
+    uint8_t freeSlot(const uint8_t *pinned) const;
+};